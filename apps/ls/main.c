@@ -0,0 +1,45 @@
+#include <estros/file.h>
+#include <estros/info.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// enough for a couple hundred short names, so most directories take one call
+static uint8_t records[4096] __attribute__((aligned(4)));
+
+static const char* type_name(uint8_t type)
+{
+    switch (type) {
+    case 1:
+        return "file";
+    case 2:
+        return "dir";
+    case 3:
+        return "dev";
+    }
+    return "?";
+}
+
+int main(int argc, char** argv)
+{
+    InfoPage* self = get_info_page();
+    char* path = argc > 1 ? argv[1] : "/";
+
+    char line[128];
+    uint32_t cookie = DIRECTORY_COOKIE_START;
+    while (cookie != DIRECTORY_COOKIE_END) {
+        uint32_t length = get_directory_entries(path, &cookie, records, sizeof(records));
+        if (length == 0 && cookie != DIRECTORY_COOKIE_END) {
+            gob_sprintf(line, "Failed to list %.100s\n", path);
+            write_file(self->stderr, line, strlen(line));
+            return 1;
+        }
+        for (uint32_t offset = 0; offset < length;) {
+            DirectoryRecord* record = (DirectoryRecord*)(records + offset);
+            gob_sprintf(line, "%-4s %8u %.100s\n", type_name(record->type), record->size, record->name);
+            write_file(self->stdout, line, strlen(line));
+            offset += record->record_length;
+        }
+    }
+    return 0;
+}
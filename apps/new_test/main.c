@@ -1,15 +1,27 @@
-
+#include <estros.h>
 #include <estros/file.h>
+#include <estros/info.h>
 #include <estros/keyboard.h>
 #include <estros/process.h>
 #include <stdio.h>
 #include <string.h>
 
-int main()
+// starts /apps/argv[0], the std files are closed when the app exits
+static uint32_t start_app(char** argv, File* stdout, File* stdin, File* stderr)
 {
     char path_to_apps[] = "/apps/";
+    char full_path[strlen(path_to_apps) + strlen(argv[0]) + 1];
+    memcpy(full_path, path_to_apps, strlen(path_to_apps));
+    memcpy(full_path + strlen(path_to_apps), argv[0], strlen(argv[0]));
+    full_path[strlen(path_to_apps) + strlen(argv[0])] = '\0';
+    argv[0] = full_path;
 
-    Process* p = get_current_process();
+    return spawn(full_path, argv, stdout, stdin, stderr);
+}
+
+int main()
+{
+    InfoPage* p = get_info_page();
 
     while (1) {
         write_file(p->stdout, ">", 1);
@@ -18,15 +30,61 @@ int main()
         while (read_file(p->stdin, &input_buffer[63], 1) != 0)
             ;
 
-        char full_path[strlen(path_to_apps) + strlen(input_buffer) + 1];
-        memcpy(full_path, path_to_apps, strlen(path_to_apps));
-        memcpy(full_path + strlen(path_to_apps), input_buffer, strlen(input_buffer));
-        full_path[strlen(path_to_apps) + strlen(input_buffer)] = '\0';
+        // the first word is the program, the rest are its arguments
+        char* argv[16] = { 0 };
+        uint32_t argc = 0;
+        for (char* c = input_buffer; *c != '\0' && argc < 15; c++) {
+            if (*c == ' ' || *c == '\n') {
+                *c = '\0';
+            } else if (c == input_buffer || c[-1] == '\0') {
+                argv[argc++] = c;
+            }
+        }
+        if (argc == 0) {
+            continue;
+        }
+
+        // "a | b" feeds the output of a to b through a pipe
+        char** second = 0;
+        for (uint32_t i = 0; i < argc; i++) {
+            if (strcmp(argv[i], "|") == 0) {
+                argv[i] = 0;
+                second = &argv[i + 1];
+                break;
+            }
+        }
+        if (second != 0 && (argv[0] == 0 || second[0] == 0)) {
+            continue;
+        }
 
         File* tty = open_file("/dev/tty", ESTROS_READ | ESTROS_WRITE);
-        Process* child = launch_file(full_path, tty, tty, tty);
-        while (child != (void*)0 && child->state != PROCESS_TERMINATED)
-            ;
+        if (second == 0) {
+            uint32_t child = start_app(argv, tty, tty, tty);
+            if (child != (uint32_t)-1) {
+                sys_wait_child(child, (void*)0);
+            }
+            continue;
+        }
+
+        File *read_end, *write_end;
+        if (create_pipe(&read_end, &write_end) != 0) {
+            close_file(tty);
+            continue;
+        }
+        File* second_tty = open_file("/dev/tty", ESTROS_READ | ESTROS_WRITE);
+        uint32_t first_child = start_app(argv, write_end, tty, tty);
+        uint32_t second_child = start_app(second, second_tty, read_end, second_tty);
+        // an end nobody got has to be closed here or the other app waits on it forever
+        if (first_child != (uint32_t)-1) {
+            sys_wait_child(first_child, (void*)0);
+        } else {
+            close_file(write_end);
+        }
+        if (second_child != (uint32_t)-1) {
+            sys_wait_child(second_child, (void*)0);
+        } else {
+            close_file(read_end);
+        }
     }
 
     return 0;
@@ -0,0 +1,106 @@
+#include <estros/file.h>
+#include <estros/info.h>
+#include <estros/process.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_PROCESSES 64
+
+static ProcessInfo previous[MAX_PROCESSES];
+static uint32_t previous_count = 0;
+
+static const char* state_name(uint8_t state)
+{
+    switch (state) {
+    case PROCESS_TERMINATED:
+        return "dead";
+    case PROCESS_RUNNING:
+        return "run";
+    case PROCESS_SUSPENDED:
+        return "susp";
+    case PROCESS_SLEEPING:
+        return "sleep";
+    case PROCESS_ZOMBIE:
+        return "zombie";
+    }
+    return "?";
+}
+
+// time used since the last refresh, or since the start for new processes
+static uint64_t time_delta(ProcessInfo* info, uint64_t* user, uint64_t* kernel)
+{
+    *user = info->user_time;
+    *kernel = info->kernel_time;
+    for (uint32_t i = 0; i < previous_count; i++) {
+        if (previous[i].id == info->id && strcmp(previous[i].name, info->name) == 0) {
+            *user -= previous[i].user_time;
+            *kernel -= previous[i].kernel_time;
+            break;
+        }
+    }
+    return *user + *kernel;
+}
+
+static void print_table(File* out, ProcessInfo* processes, uint32_t count)
+{
+    char line[128];
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t user, kernel;
+        total += time_delta(&processes[i], &user, &kernel);
+    }
+    if (total == 0) {
+        total = 1;
+    }
+
+    uint32_t command = 0; // clear
+    ioctl(out, &command, 0);
+
+    gob_sprintf(line, "%5s %-16s %-6s %3s %5s %5s %5s %8s %8s %8s\n", "PID", "NAME", "STATE", "CPU", "%CPU", "%USR", "%SYS", "SWITCH", "VOL", "INVOL");
+    write_file(out, line, strlen(line));
+    for (uint32_t i = 0; i < count; i++) {
+        ProcessInfo* info = &processes[i];
+        uint64_t user, kernel;
+        uint64_t used = time_delta(info, &user, &kernel);
+        gob_sprintf(line, "%5u %-16.16s %-6s %3u %5u %5u %5u %8u %8u %8u\n",
+            info->id, info->name, state_name(info->state), info->cpu,
+            (uint32_t)(used * 100 / total), (uint32_t)(user * 100 / total), (uint32_t)(kernel * 100 / total),
+            info->context_switches, info->voluntary_switches, info->involuntary_switches);
+        write_file(out, line, strlen(line));
+    }
+    const char* help = "\nenter to refresh, q to quit\n";
+    write_file(out, (void*)help, strlen(help));
+}
+
+int main()
+{
+    InfoPage* self = get_info_page();
+    ProcessInfo processes[MAX_PROCESSES];
+
+    while (1) {
+        // the kernel takes the snapshot on open
+        File* proc = open_file("/sys/proc", ESTROS_READ);
+        if (proc == 0) {
+            const char* error = "Unable to open /sys/proc\n";
+            write_file(self->stdout, (void*)error, strlen(error));
+            return 1;
+        }
+        uint32_t count = read_file(proc, processes, sizeof(processes)) / sizeof(ProcessInfo);
+        close_file(proc);
+
+        print_table(self->stdout, processes, count);
+
+        memcpy(previous, processes, sizeof(ProcessInfo) * count);
+        previous_count = count;
+
+        char input[16] = { 0 };
+        read_file(self->stdin, input, sizeof(input) - 1);
+        while (read_file(self->stdin, &input[15], 1) != 0)
+            ;
+        if (input[0] == 'q') {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "async_io.h"
+#include <filesystem/io-queue.h>
+#include <heap.h>
+#include <print.h>
+#include <spinlock.h>
+
+void async_io_complete(VFSRequest* request)
+{
+    struct async_io* io = request->private_data;
+    if (io->waiter == PROCESS_INVALID_ID) {
+        return;
+    }
+    struct process* waiter = find_process(io->waiter);
+    if (waiter != NULL && waiter->state == PROCESS_SUSPENDED) {
+        wake_process(waiter);
+    }
+}
+
+struct async_io* async_io_submit(struct process* process, VFSFile* file, void* buffer, uint32_t length, uint8_t write)
+{
+    struct process* leader = get_process_by_id(process->group_id);
+    if (leader == NULL || file == NULL) {
+        return NULL;
+    }
+    struct async_io* io = malloc(sizeof(struct async_io));
+    if (io == NULL) {
+        printf("Failed to allocate async request for process %d\n", leader->id);
+        return NULL;
+    }
+    io->request = (VFSRequest) {
+        .file = file,
+        .buffer = buffer,
+        .length = length,
+        .write = write,
+        .complete = async_io_complete,
+        .private_data = io,
+    };
+    io->waiter = PROCESS_INVALID_ID;
+    io->next = leader->async_io;
+    leader->async_io = io;
+
+    if (file->inode->file_operations.submit == NULL && !write && file->inode->type != VFS_PIPE) {
+        // same as the read system call, the fallback can block on input
+        spin_unlock(&kernel_lock);
+        __asm__("sti\n");
+        vfs_submit(&io->request);
+        __asm__("cli\n");
+        spin_lock(&kernel_lock);
+    } else {
+        vfs_submit(&io->request);
+    }
+    return io;
+}
+
+uint32_t async_io_wait(struct process* process, struct async_io* io, uint8_t block, uint32_t* result)
+{
+    *result = 0;
+    struct process* leader = get_process_by_id(process->group_id);
+    if (leader == NULL) {
+        return ASYNC_IO_INVALID;
+    }
+    struct async_io** link = &leader->async_io;
+    while (*link != NULL && *link != io) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return ASYNC_IO_INVALID;
+    }
+
+    if (!io->request.done && block && io->waiter == PROCESS_INVALID_ID) {
+        io->waiter = process->id;
+        while (!io->request.done && process->state == PROCESS_RUNNING) {
+            // the completion runs under kernel_lock, so it can't be missed between the check and the suspend
+            process->state = PROCESS_SUSPENDED;
+            spin_unlock(&kernel_lock);
+            yield_process();
+            spin_lock(&kernel_lock);
+        }
+        io->waiter = PROCESS_INVALID_ID;
+    }
+    if (!io->request.done) {
+        return ASYNC_IO_PENDING;
+    }
+
+    // the list may have changed while the thread slept
+    link = &leader->async_io;
+    while (*link != io) {
+        link = &(*link)->next;
+    }
+    *link = io->next;
+    *result = io->request.result;
+    free(io);
+    return ASYNC_IO_DONE;
+}
+
+void async_io_release(struct process* leader)
+{
+    struct async_io* io = leader->async_io;
+    while (io != NULL) {
+        struct async_io* next = io->next;
+        // a request that isn't done is queued or running on the io queue thread, which won't touch it after this
+        if (!io->request.done) {
+            io_queue_cancel(&io->request);
+        }
+        free(io);
+        io = next;
+    }
+    leader->async_io = NULL;
+}
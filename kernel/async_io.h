@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <process.h>
+#include <stdint.h>
+
+// reads and writes a process started with the async system calls, the handle given to the process is the address of the entry
+// they are kept on the main thread until one of the threads collects the result, whatever is left is dropped when the process is reaped
+struct async_io {
+    VFSRequest request;
+    uint32_t waiter; // thread blocked in async_io_wait, PROCESS_INVALID_ID if none
+    struct async_io* next;
+};
+
+enum {
+    ASYNC_IO_DONE = 0,
+    ASYNC_IO_PENDING = 1,
+    ASYNC_IO_INVALID = 2, // not a request of the process or it was collected already
+};
+
+// all of these expect kernel_lock to be held
+
+// returns NULL on fail, drivers without a submit operation finish the request before this returns
+struct async_io* async_io_submit(struct process* process, VFSFile* file, void* buffer, uint32_t length, uint8_t write);
+// collects the result of a finished request, with block the thread sleeps until it's done
+// only one thread can wait for a request, the others get ASYNC_IO_PENDING
+uint32_t async_io_wait(struct process* process, struct async_io* io, uint8_t block, uint32_t* result);
+// cancels the queued requests and frees every entry of the main thread
+void async_io_release(struct process* leader);
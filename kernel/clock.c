@@ -0,0 +1,92 @@
+#include "clock.h"
+#include <heap.h>
+#include <memutils.h>
+#include <pager.h>
+#include <pit.h>
+#include <print.h>
+#include <stdint.h>
+#include <tsc.h>
+
+#define CALIBRATION_US 50000
+
+uint32_t tsc_ticks_per_ms = 0;
+uint64_t tsc_boot = 0;
+
+// there is no libgcc, so 64 bit division goes through divl one half at a time
+uint64_t div_u64_rem(uint64_t dividend, uint32_t divisor, uint32_t* remainder)
+{
+    uint32_t high = dividend >> 32;
+    uint32_t low = (uint32_t)dividend;
+    uint32_t quotient_high = high / divisor;
+    high %= divisor;
+    uint32_t quotient_low;
+    __asm__("divl %4" : "=a"(quotient_low), "=d"(*remainder) : "a"(low), "d"(high), "rm"(divisor));
+    return ((uint64_t)quotient_high << 32) | quotient_low;
+}
+
+void clock_init()
+{
+    uint64_t start = read_tsc();
+    pit_wait_us(CALIBRATION_US);
+    uint64_t end = read_tsc();
+    tsc_ticks_per_ms = (uint32_t)(end - start) / (CALIBRATION_US / 1000);
+    if (tsc_ticks_per_ms == 0) {
+        tsc_ticks_per_ms = 1;
+    }
+    tsc_boot = start;
+
+    struct time_page* page = malloc_aligned(PAGE_SIZE, PAGE_SIZE);
+    if (page == NULL) {
+        printf("Failed to malloc the time page\n");
+        return;
+    }
+    memset(page, 0, PAGE_SIZE);
+    page->version = 1;
+    page->tsc_ticks_per_ms = tsc_ticks_per_ms;
+    page->tsc_boot = tsc_boot;
+    page->resolution_ns = 1000000 / tsc_ticks_per_ms;
+    if (page->resolution_ns == 0) {
+        page->resolution_ns = 1;
+    }
+    // the low 4MB are shared by every table, so mapping it once is enough
+    map_page(page, (void*)TIME_PAGE_ADDRESS, &kernel_table->pde, PAGE_GLOBAL);
+
+    printf("TSC runs at %d kHz\n", tsc_ticks_per_ms);
+}
+
+uint64_t tsc_to_ns(uint64_t ticks)
+{
+    uint32_t remainder;
+    uint64_t milliseconds = div_u64_rem(ticks, tsc_ticks_per_ms, &remainder);
+    uint32_t unused;
+    return milliseconds * 1000000 + div_u64_rem((uint64_t)remainder * 1000000, tsc_ticks_per_ms, &unused);
+}
+
+uint64_t clock_monotonic_ns()
+{
+    return tsc_to_ns(read_tsc() - tsc_boot);
+}
+
+int clock_gettime(uint32_t clock_id, struct clock_timespec* timespec)
+{
+    if (clock_id != CLOCK_MONOTONIC || timespec == NULL) {
+        return 1;
+    }
+    uint32_t nanoseconds;
+    timespec->seconds = div_u64_rem(clock_monotonic_ns(), 1000000000, &nanoseconds);
+    timespec->nanoseconds = nanoseconds;
+    return 0;
+}
+
+int clock_getres(uint32_t clock_id, struct clock_timespec* timespec)
+{
+    if (clock_id != CLOCK_MONOTONIC || timespec == NULL) {
+        return 1;
+    }
+    timespec->seconds = 0;
+    timespec->nanoseconds = 1000000 / tsc_ticks_per_ms;
+    if (timespec->nanoseconds == 0) {
+        timespec->nanoseconds = 1;
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+// tsc based monotonic clock, calibrated against the pit at boot
+// assumes an invariant tsc that is in sync between cpus
+
+enum {
+    CLOCK_MONOTONIC = 1,
+};
+
+// same layout as struct timespec in goblibc
+struct clock_timespec {
+    uint64_t seconds;
+    uint32_t nanoseconds;
+    uint32_t reserved;
+};
+
+// read only page mapped at the same address in every page table
+// userspace converts the tsc itself with these values instead of making a syscall
+#define TIME_PAGE_ADDRESS 0x2FD000
+
+struct time_page {
+    uint32_t version;
+    uint32_t tsc_ticks_per_ms;
+    uint64_t tsc_boot; // tsc value at clock zero
+    uint32_t resolution_ns;
+};
+
+// must be called once before interrupts are enabled and after the kernel table is loaded
+void clock_init();
+
+uint64_t tsc_to_ns(uint64_t ticks);
+uint64_t clock_monotonic_ns();
+
+// return 0 on success
+int clock_gettime(uint32_t clock_id, struct clock_timespec* timespec);
+int clock_getres(uint32_t clock_id, struct clock_timespec* timespec);
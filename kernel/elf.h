@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+// the parts of the 32 bit elf format the loader uses
+
+#define ELF_MAGIC 0x464c457f // "\x7fELF"
+#define ELF_CLASS_32 1
+#define ELF_DATA_LITTLE_ENDIAN 1
+#define ELF_TYPE_EXECUTABLE 2
+#define ELF_MACHINE_386 3
+
+struct elf_header {
+    uint32_t magic;
+    uint8_t class;
+    uint8_t data;
+    uint8_t version;
+    uint8_t padding[9];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t file_version;
+    uint32_t entry;
+    uint32_t program_header_offset;
+    uint32_t section_header_offset;
+    uint32_t flags;
+    uint16_t header_size;
+    uint16_t program_header_size;
+    uint16_t program_header_count;
+    uint16_t section_header_size;
+    uint16_t section_header_count;
+    uint16_t section_names_index;
+} __attribute__((packed));
+
+enum {
+    ELF_SEGMENT_LOAD = 1,
+    ELF_SEGMENT_INTERP = 3, // path of the library the program is linked against
+    ELF_SEGMENT_GNU_STACK = 0x6474e551, // memory_size is the stack size when linked with -z stack-size
+};
+
+enum {
+    ELF_SEGMENT_EXECUTABLE = 1,
+    ELF_SEGMENT_WRITEABLE = 1 << 1,
+    ELF_SEGMENT_READABLE = 1 << 2,
+};
+
+struct elf_program_header {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t virtual_address;
+    uint32_t physical_address;
+    uint32_t file_size;
+    uint32_t memory_size;
+    uint32_t flags;
+    uint32_t alignment;
+} __attribute__((packed));
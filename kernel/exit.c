@@ -4,7 +4,6 @@
 #include <memutils.h>
 #include <print.h>
 #include <stdint.h>
-#include <time.h>
 #include <trace.h>
 
 void emergency_print(char* str)
@@ -31,11 +30,7 @@ void exit_kernel()
 
     set_print_output("/dev/tty");
 
-    uint8_t buffer[1024];
-    uint32_t length = 0;
-    while ((length = vfs_read(log, buffer, 1024)) > 0) {
-        vfs_write(tty, buffer, length);
-    }
+    vfs_transfer(tty, log, log->inode->size);
     vfs_write(tty, "\ntail of /sys/kernel.log\nexited kernel\n", strlen("\ntail of /sys/kernel.log\nexited kernel\n"));
     run_stack_trace();
 
@@ -0,0 +1,199 @@
+#include "block-cache.h"
+#include <heap.h>
+#include <memutils.h>
+#include <spinlock.h>
+
+struct block_cache_entry block_cache[BLOCK_CACHE_PAGES] = { 0 };
+struct block_cache_entry* block_cache_buckets[BLOCK_CACHE_BUCKETS] = { 0 };
+uint32_t block_cache_hand = 0;
+spinlock_t block_cache_lock = SPINLOCK_INIT;
+
+static uint32_t bucket_index(VFSFile* device, uint32_t page)
+{
+    return ((uint32_t)device / sizeof(VFSFile) + page) % BLOCK_CACHE_BUCKETS;
+}
+
+static struct block_cache_entry* find_entry(VFSFile* device, uint32_t page)
+{
+    struct block_cache_entry* entry = block_cache_buckets[bucket_index(device, page)];
+    for (; entry != NULL; entry = entry->next) {
+        if (entry->device == device && entry->page == page) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void remove_entry(struct block_cache_entry* entry)
+{
+    struct block_cache_entry** link = &block_cache_buckets[bucket_index(entry->device, entry->page)];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    entry->next = NULL;
+    entry->device = NULL;
+}
+
+static uint8_t write_back(struct block_cache_entry* entry)
+{
+    vfs_seek(entry->device, entry->page * BLOCK_CACHE_PAGE_SIZE, VFS_BEG);
+    if (vfs_write(entry->device, entry->data, BLOCK_CACHE_PAGE_SIZE) != BLOCK_CACHE_PAGE_SIZE) {
+        return 1;
+    }
+    entry->dirty = 0;
+    return 0;
+}
+
+// returns an entry without a page, the memory for it is only allocated when the budget isn't used up yet
+static struct block_cache_entry* find_victim()
+{
+    // two turns clear every referenced bit, dirty pages that can't be written are skipped
+    for (uint32_t i = 0; i < BLOCK_CACHE_PAGES * 3; i++) {
+        struct block_cache_entry* entry = &block_cache[block_cache_hand];
+        block_cache_hand = (block_cache_hand + 1) % BLOCK_CACHE_PAGES;
+        if (entry->data == NULL) {
+            entry->data = malloc(BLOCK_CACHE_PAGE_SIZE);
+            if (entry->data == NULL) {
+                continue;
+            }
+            return entry;
+        }
+        if (entry->device == NULL) {
+            return entry;
+        }
+        if (entry->pinned) {
+            continue;
+        }
+        if (entry->referenced) {
+            entry->referenced = 0;
+            continue;
+        }
+        if (entry->dirty && write_back(entry) != 0) {
+            continue;
+        }
+        remove_entry(entry);
+        return entry;
+    }
+    return NULL;
+}
+
+// returns the cached page, it's read from the device unless the caller overwrites all of it
+static struct block_cache_entry* get_entry(VFSFile* device, uint32_t page, uint8_t overwrite)
+{
+    struct block_cache_entry* entry = find_entry(device, page);
+    if (entry != NULL) {
+        entry->referenced = 1;
+        return entry;
+    }
+    entry = find_victim();
+    if (entry == NULL) {
+        return NULL;
+    }
+    if (!overwrite) {
+        vfs_seek(device, page * BLOCK_CACHE_PAGE_SIZE, VFS_BEG);
+        if (vfs_read(device, entry->data, BLOCK_CACHE_PAGE_SIZE) != BLOCK_CACHE_PAGE_SIZE) {
+            return NULL;
+        }
+    }
+    uint32_t index = bucket_index(device, page);
+    entry->device = device;
+    entry->page = page;
+    entry->dirty = 0;
+    entry->referenced = 1;
+    entry->next = block_cache_buckets[index];
+    block_cache_buckets[index] = entry;
+    return entry;
+}
+
+uint8_t block_cache_read(VFSFile* device, uint32_t offset, void* buffer, uint32_t length)
+{
+    uint32_t eflags = spin_lock_irqsave(&block_cache_lock);
+    uint8_t result = 0;
+    while (length > 0) {
+        uint32_t page_offset = offset % BLOCK_CACHE_PAGE_SIZE;
+        uint32_t part = BLOCK_CACHE_PAGE_SIZE - page_offset < length ? BLOCK_CACHE_PAGE_SIZE - page_offset : length;
+        struct block_cache_entry* entry = get_entry(device, offset / BLOCK_CACHE_PAGE_SIZE, 0);
+        if (entry == NULL) {
+            result = 1;
+            break;
+        }
+        memcpy(buffer, entry->data + page_offset, part);
+        buffer = (uint8_t*)buffer + part;
+        offset += part;
+        length -= part;
+    }
+    spin_unlock_irqrestore(&block_cache_lock, eflags);
+    return result;
+}
+
+uint8_t block_cache_write(VFSFile* device, uint32_t offset, void* buffer, uint32_t length)
+{
+    uint32_t eflags = spin_lock_irqsave(&block_cache_lock);
+    uint8_t result = 0;
+    while (length > 0) {
+        uint32_t page_offset = offset % BLOCK_CACHE_PAGE_SIZE;
+        uint32_t part = BLOCK_CACHE_PAGE_SIZE - page_offset < length ? BLOCK_CACHE_PAGE_SIZE - page_offset : length;
+        struct block_cache_entry* entry = get_entry(device, offset / BLOCK_CACHE_PAGE_SIZE, part == BLOCK_CACHE_PAGE_SIZE);
+        if (entry == NULL) {
+            result = 1;
+            break;
+        }
+        memcpy(entry->data + page_offset, buffer, part);
+        entry->dirty = 1;
+        buffer = (uint8_t*)buffer + part;
+        offset += part;
+        length -= part;
+    }
+    spin_unlock_irqrestore(&block_cache_lock, eflags);
+    return result;
+}
+
+uint8_t* block_cache_pin(VFSFile* device, uint32_t offset)
+{
+    uint32_t eflags = spin_lock_irqsave(&block_cache_lock);
+    struct block_cache_entry* entry = get_entry(device, offset / BLOCK_CACHE_PAGE_SIZE, 0);
+    uint8_t* data = NULL;
+    if (entry != NULL) {
+        entry->pinned++;
+        data = entry->data + offset % BLOCK_CACHE_PAGE_SIZE;
+    }
+    spin_unlock_irqrestore(&block_cache_lock, eflags);
+    return data;
+}
+
+void block_cache_unpin(VFSFile* device, uint32_t offset)
+{
+    uint32_t eflags = spin_lock_irqsave(&block_cache_lock);
+    struct block_cache_entry* entry = find_entry(device, offset / BLOCK_CACHE_PAGE_SIZE);
+    if (entry != NULL && entry->pinned > 0) {
+        entry->pinned--;
+    }
+    spin_unlock_irqrestore(&block_cache_lock, eflags);
+}
+
+uint8_t block_cache_contains(VFSFile* device, uint32_t offset, uint32_t length)
+{
+    if (length == 0) {
+        return 1;
+    }
+    uint32_t eflags = spin_lock_irqsave(&block_cache_lock);
+    uint8_t contains = 1;
+    uint32_t last = (offset + length - 1) / BLOCK_CACHE_PAGE_SIZE;
+    for (uint32_t page = offset / BLOCK_CACHE_PAGE_SIZE; contains && page <= last; page++) {
+        contains = find_entry(device, page) != NULL;
+    }
+    spin_unlock_irqrestore(&block_cache_lock, eflags);
+    return contains;
+}
+
+void block_cache_sync(VFSFile* device)
+{
+    uint32_t eflags = spin_lock_irqsave(&block_cache_lock);
+    for (uint32_t i = 0; i < BLOCK_CACHE_PAGES; i++) {
+        if (block_cache[i].device == device && block_cache[i].dirty) {
+            write_back(&block_cache[i]);
+        }
+    }
+    spin_unlock_irqrestore(&block_cache_lock, eflags);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+// page sized pieces of block devices shared by every file on them, keyed by the device file and the page number
+// pages are written back when they are evicted or the device is synced, the victim is picked with the clock algorithm
+// every function takes block_cache_lock, so files on the device can be read without kernel_lock
+// the device is read and written with the lock held and interrupts off
+#define BLOCK_CACHE_PAGE_SIZE 0x1000
+// the memory budget in pages, set with BLOCK_CACHE_PAGES= in the makefile
+#ifndef BLOCK_CACHE_PAGES
+#define BLOCK_CACHE_PAGES 32
+#endif
+#define BLOCK_CACHE_BUCKETS 64
+
+struct block_cache_entry {
+    VFSFile* device; // NULL while the entry is unused
+    uint32_t page;
+    uint8_t* data;
+    uint8_t dirty;
+    uint8_t referenced; // cleared when the clock hand passes, the page is evicted on the next pass
+    uint8_t pinned; // number of block_cache_pin callers using the page in place, the clock skips it meanwhile
+    struct block_cache_entry* next; // in the bucket
+};
+
+// copy length bytes at offset of the device from or into the cache, the pages are read from the device on a miss
+// returns 0 on success, 1 if the device couldn't be read or written
+uint8_t block_cache_read(VFSFile* device, uint32_t offset, void* buffer, uint32_t length);
+uint8_t block_cache_write(VFSFile* device, uint32_t offset, void* buffer, uint32_t length);
+// returns 1 if every page of the range is cached, so reading it doesn't touch the device
+uint8_t block_cache_contains(VFSFile* device, uint32_t offset, uint32_t length);
+// returns the cached byte at offset so the caller can read up to the end of its page without a copy, NULL if it couldn't be read
+// the page isn't evicted until it's given back with block_cache_unpin
+uint8_t* block_cache_pin(VFSFile* device, uint32_t offset);
+void block_cache_unpin(VFSFile* device, uint32_t offset);
+// writes the dirty pages of the device
+void block_cache_sync(VFSFile* device);
@@ -1,4 +1,6 @@
 #include "estros-fs.h"
+#include <filesystem/block-cache.h>
+#include <filesystem/io-queue.h>
 #include <filesystem/virtual-filesystem.h>
 #include <harddrive/hdd.h>
 #include <heap.h>
@@ -34,6 +36,11 @@ struct DirectoryEntry {
     char name[];
 };
 
+// private data of an open file
+struct FileData {
+    uint8_t written; // only files that were written sync the disk when they're closed
+};
+
 struct SuperBlock {
     uint64_t size_bytes;
     uint32_t n_blocks;
@@ -42,12 +49,6 @@ struct SuperBlock {
     uint32_t root_inode;
 };
 
-struct FileData {
-    uint8_t* data;
-    uint32_t range_low;
-    uint32_t range_high;
-};
-
 struct SuperBlock super_block = { 0 };
 
 #define SINGLE_INDIRECT_INDEX NUM_DIRECT_BLOCKS
@@ -66,24 +67,24 @@ struct SuperBlock super_block = { 0 };
 
 VFSFile* harddrive = NULL;
 
+// every read and write of the disk goes through the block cache, files opened on it share the cached pages
 void fs_set_harddrive(char* path)
 {
     harddrive = vfs_open_file(path, 0);
-    uint8_t sector[512];
-    vfs_seek(harddrive, 0x10000, VFS_BEG);
-    vfs_read(harddrive, sector, 512);
-    memcpy(&super_block, sector, sizeof(struct SuperBlock));
+    block_cache_read(harddrive, SUPER_BLOCK_OFFSET, &super_block, sizeof(struct SuperBlock));
     return;
 };
 
+void write_super_block()
+{
+    block_cache_write(harddrive, SUPER_BLOCK_OFFSET, &super_block, sizeof(struct SuperBlock));
+}
+
 uint32_t alloc_block()
 {
     uint32_t block = super_block.n_blocks;
     super_block.n_blocks++;
-    uint8_t sector[512];
-    memcpy(sector, &super_block, sizeof(struct SuperBlock));
-    vfs_seek(harddrive, 0x10000, VFS_BEG);
-    vfs_write(harddrive, sector, 512);
+    write_super_block();
     return block;
 }
 
@@ -91,13 +92,19 @@ uint32_t alloc_inode()
 {
     uint32_t block = super_block.n_inodes;
     super_block.n_inodes++;
-    uint8_t sector[512];
-    memcpy(sector, &super_block, sizeof(struct SuperBlock));
-    vfs_seek(harddrive, 0x10000, VFS_BEG);
-    vfs_write(harddrive, sector, 512);
+    write_super_block();
     return block; // Out of space
 }
 
+// blocks of pointers have to start out empty
+uint32_t alloc_pointer_block()
+{
+    static uint8_t zeroes[BLOCK_SIZE] = { 0 };
+    uint32_t block = alloc_block();
+    block_cache_write(harddrive, block * BLOCK_SIZE, zeroes, BLOCK_SIZE);
+    return block;
+}
+
 VFSIndexNode fstovfs(struct Inode inode, uint32_t inode_number)
 {
     VFSIndexNode vfs_inode = {
@@ -134,83 +141,72 @@ void write_inode(struct Inode inode, uint32_t inode_number)
     uint32_t inode_offset = ((SUPER_BLOCK_OFFSET + BLOCK_SIZE + BLOCK_BP_SIZE + INODE_BP_SIZE) / BLOCK_SIZE + 1) * BLOCK_SIZE
         + (inode_number * INODE_SIZE);
 
-    uint8_t buffer[512];
-
-    vfs_seek(harddrive, inode_offset, VFS_BEG);
-    vfs_read(harddrive, buffer, 512);
+    block_cache_write(harddrive, inode_offset, &inode, INODE_SIZE);
+}
 
-    uint32_t sub_offset = inode_number % 8;
-    memcpy(&buffer[sub_offset * INODE_SIZE], &inode, INODE_SIZE);
+// returns the disk block holding block block_n of the file, 0 if it doesn't have one
+// with allocate the missing data and pointer blocks are allocated, only the triple indirect blocks can't be
+// the pointers are read one at a time from the cached pages
+uint32_t get_real_block(uint32_t blocks[13], uint32_t block_n, uint8_t allocate)
+{
+    if (block_n < NUM_DIRECT_BLOCKS) {
+        if (blocks[block_n] == 0 && allocate) {
+            blocks[block_n] = alloc_block();
+        }
+        return blocks[block_n];
+    }
+
+    uint32_t index = block_n - NUM_DIRECT_BLOCKS;
+    uint32_t levels = 1;
+    uint32_t* table = &blocks[SINGLE_INDIRECT_INDEX];
+    if (index >= PTRS_PER_BLOCK) {
+        index -= PTRS_PER_BLOCK;
+        levels = 2;
+        table = &blocks[DOUBLE_INDIRECT_INDEX];
+        if (index >= PTRS_PER_BLOCK * PTRS_PER_BLOCK) {
+            index -= PTRS_PER_BLOCK * PTRS_PER_BLOCK;
+            levels = 3;
+            table = &blocks[TRIPLE_INDIRECT_INDEX];
+            allocate = 0;
+        }
+    }
+    if (*table == 0) {
+        if (!allocate) {
+            return 0;
+        }
+        *table = alloc_pointer_block();
+    }
 
-    vfs_seek(harddrive, inode_offset, VFS_BEG);
-    vfs_write(harddrive, buffer, 512);
+    uint32_t block = *table;
+    for (uint32_t level = levels; level > 0; level--) {
+        uint32_t divisor = level == 3 ? PTRS_PER_BLOCK * PTRS_PER_BLOCK : (level == 2 ? PTRS_PER_BLOCK : 1);
+        uint32_t pointer_offset = block * BLOCK_SIZE + ((index / divisor) % PTRS_PER_BLOCK) * sizeof(uint32_t);
+        uint32_t next = 0;
+        if (block_cache_read(harddrive, pointer_offset, &next, sizeof(uint32_t)) != 0) {
+            return 0;
+        }
+        if (next == 0) {
+            if (!allocate) {
+                return 0;
+            }
+            next = level > 1 ? alloc_pointer_block() : alloc_block();
+            block_cache_write(harddrive, pointer_offset, &next, sizeof(uint32_t));
+        }
+        block = next;
+    }
+    return block;
 }
 
 void* harddrive_load_blocks(void* buffer, uint32_t blocks[13], uint32_t pos, uint32_t num_blocks)
 {
     for (uint32_t i = 0; i < num_blocks; i++) {
-
-        uint32_t block_n = (pos + i * BLOCK_SIZE) / BLOCK_SIZE;
-
-        uint32_t real_block = 0xFFFFFFFF;
-
-        if (block_n < NUM_DIRECT_BLOCKS) {
-            real_block = blocks[block_n];
-        } else if (block_n < NUM_DIRECT_BLOCKS + PTRS_PER_BLOCK) {
-            // Single indirect
-            uint32_t index = block_n - NUM_DIRECT_BLOCKS;
-            uint32_t single_ptrs[PTRS_PER_BLOCK];
-            vfs_seek(harddrive, blocks[SINGLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, single_ptrs, BLOCK_SIZE);
-            real_block = single_ptrs[index];
-        } else if (block_n < NUM_DIRECT_BLOCKS + PTRS_PER_BLOCK + PTRS_PER_BLOCK * PTRS_PER_BLOCK) {
-            // Double indirect
-            uint32_t index = block_n - NUM_DIRECT_BLOCKS - PTRS_PER_BLOCK;
-            uint32_t l1 = index / PTRS_PER_BLOCK;
-            uint32_t l2 = index % PTRS_PER_BLOCK;
-
-            uint32_t double_ptrs[PTRS_PER_BLOCK];
-            uint32_t single_ptrs[PTRS_PER_BLOCK];
-
-            vfs_seek(harddrive, blocks[DOUBLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, double_ptrs, BLOCK_SIZE);
-
-            vfs_seek(harddrive, double_ptrs[l1] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, single_ptrs, BLOCK_SIZE);
-
-            real_block = single_ptrs[l2];
-        } else {
-            // Triple indirect
-            uint32_t index = block_n - NUM_DIRECT_BLOCKS - PTRS_PER_BLOCK - PTRS_PER_BLOCK * PTRS_PER_BLOCK;
-            uint32_t l1 = index / (PTRS_PER_BLOCK * PTRS_PER_BLOCK);
-            uint32_t l2 = (index / PTRS_PER_BLOCK) % PTRS_PER_BLOCK;
-            uint32_t l3 = index % PTRS_PER_BLOCK;
-
-            uint32_t triple_ptrs[PTRS_PER_BLOCK];
-            uint32_t double_ptrs[PTRS_PER_BLOCK];
-            uint32_t single_ptrs[PTRS_PER_BLOCK];
-
-            vfs_seek(harddrive, blocks[TRIPLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, triple_ptrs, BLOCK_SIZE);
-
-            vfs_seek(harddrive, triple_ptrs[l1] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, double_ptrs, BLOCK_SIZE);
-
-            vfs_seek(harddrive, double_ptrs[l2] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, single_ptrs, BLOCK_SIZE);
-
-            real_block = single_ptrs[l3];
-        }
-
-        if (real_block == 0 || real_block == 0xFFFFFFFF) {
+        uint32_t real_block = get_real_block(blocks, (pos + i * BLOCK_SIZE) / BLOCK_SIZE, 0);
+        if (real_block == 0 || block_cache_read(harddrive, real_block * BLOCK_SIZE, (uint8_t*)buffer + (i * BLOCK_SIZE), BLOCK_SIZE) != 0) {
             if (i != 0) {
                 return buffer;
             }
             return NULL;
         }
-
-        vfs_seek(harddrive, real_block * BLOCK_SIZE, VFS_BEG);
-        vfs_read(harddrive, buffer + (i * BLOCK_SIZE), BLOCK_SIZE);
     }
 
     return buffer;
@@ -219,244 +215,178 @@ void* harddrive_load_blocks(void* buffer, uint32_t blocks[13], uint32_t pos, uin
 void harddrive_write_blocks(void* buffer, uint32_t blocks[13], uint32_t pos, uint32_t num_blocks)
 {
     for (uint32_t i = 0; i < num_blocks; i++) {
-        uint32_t block_n = (pos + i * BLOCK_SIZE) / BLOCK_SIZE;
-        uint32_t real_block = 0xFFFFFFFF;
-
-        // --- Direct blocks ---
-        if (block_n < NUM_DIRECT_BLOCKS) {
-            if (blocks[block_n] == 0) {
-                blocks[block_n] = alloc_block();
-            }
-            real_block = blocks[block_n];
-        }
-
-        // --- Single Indirect ---
-        else if (block_n < NUM_DIRECT_BLOCKS + PTRS_PER_BLOCK) {
-            uint32_t index = block_n - NUM_DIRECT_BLOCKS;
-            uint32_t single_ptrs[PTRS_PER_BLOCK] = { 0 };
-
-            if (blocks[SINGLE_INDIRECT_INDEX] == 0) {
-                blocks[SINGLE_INDIRECT_INDEX] = alloc_block();
-            }
-
-            vfs_seek(harddrive, blocks[SINGLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, single_ptrs, BLOCK_SIZE);
-
-            if (single_ptrs[index] == 0) {
-                single_ptrs[index] = alloc_block();
-                vfs_seek(harddrive, blocks[SINGLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-                vfs_write(harddrive, single_ptrs, BLOCK_SIZE);
-            }
-
-            real_block = single_ptrs[index];
-        }
-
-        // --- Double Indirect ---
-        else if (block_n < NUM_DIRECT_BLOCKS + PTRS_PER_BLOCK + PTRS_PER_BLOCK * PTRS_PER_BLOCK) {
-            uint32_t index = block_n - NUM_DIRECT_BLOCKS - PTRS_PER_BLOCK;
-            uint32_t l1 = index / PTRS_PER_BLOCK;
-            uint32_t l2 = index % PTRS_PER_BLOCK;
-
-            uint32_t double_ptrs[PTRS_PER_BLOCK] = { 0 };
-            uint32_t single_ptrs[PTRS_PER_BLOCK] = { 0 };
-
-            if (blocks[DOUBLE_INDIRECT_INDEX] == 0) {
-                blocks[DOUBLE_INDIRECT_INDEX] = alloc_block();
-            }
-
-            vfs_seek(harddrive, blocks[DOUBLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, double_ptrs, BLOCK_SIZE);
-
-            if (double_ptrs[l1] == 0) {
-                double_ptrs[l1] = alloc_block();
-                vfs_seek(harddrive, blocks[DOUBLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-                vfs_write(harddrive, double_ptrs, BLOCK_SIZE);
-            }
-
-            vfs_seek(harddrive, double_ptrs[l1] * BLOCK_SIZE, VFS_BEG);
-            vfs_read(harddrive, single_ptrs, BLOCK_SIZE);
-
-            if (single_ptrs[l2] == 0) {
-                single_ptrs[l2] = alloc_block();
-                vfs_seek(harddrive, double_ptrs[l1] * BLOCK_SIZE, VFS_BEG);
-                vfs_write(harddrive, single_ptrs, BLOCK_SIZE);
-            }
-
-            real_block = single_ptrs[l2];
-        }
-
-        // --- Triple Indirect ---
-        else {
-            // uint32_t index = block_n - NUM_DIRECT_BLOCKS - PTRS_PER_BLOCK - PTRS_PER_BLOCK * PTRS_PER_BLOCK;
-            // uint32_t l1 = index / (PTRS_PER_BLOCK * PTRS_PER_BLOCK);
-            // uint32_t l2 = (index / PTRS_PER_BLOCK) % PTRS_PER_BLOCK;
-            // uint32_t l3 = index % PTRS_PER_BLOCK;
-            //
-            // uint32_t triple_ptrs[PTRS_PER_BLOCK] = {0};
-            // uint32_t double_ptrs[PTRS_PER_BLOCK] = {0};
-            // uint32_t single_ptrs[PTRS_PER_BLOCK] = {0};
-            //
-            // if (blocks[TRIPLE_INDIRECT_INDEX] == 0) {
-            //     blocks[TRIPLE_INDIRECT_INDEX] = alloc_block();
-            // }
-            //
-            // vfs_seek(harddrive, blocks[TRIPLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-            // vfs_read(harddrive, triple_ptrs, BLOCK_SIZE);
-            //
-            // if (triple_ptrs[l1] == 0) {
-            //     triple_ptrs[l1] = alloc_block();
-            //     vfs_seek(harddrive, blocks[TRIPLE_INDIRECT_INDEX] * BLOCK_SIZE, VFS_BEG);
-            //     vfs_write(harddrive, triple_ptrs, BLOCK_SIZE);
-            // }
-            //
-            // vfs_seek(harddrive, triple_ptrs[l1] * BLOCK_SIZE, VFS_BEG);
-            // vfs_read(harddrive, double_ptrs, BLOCK_SIZE);
-            //
-            // if (double_ptrs[l2] == 0) {
-            //     double_ptrs[l2] = alloc_block();
-            //     vfs_seek(harddrive, triple_ptrs[l1] * BLOCK_SIZE, VFS_BEG);
-            //     vfs_write(harddrive, double_ptrs, BLOCK_SIZE);
-            // }
-            //
-            // vfs_seek(harddrive, double_ptrs[l2] * BLOCK_SIZE, VFS_BEG);
-            // vfs_read(harddrive, single_ptrs, BLOCK_SIZE);
-            //
-            // if (single_ptrs[l3] == 0) {
-            //     single_ptrs[l3] = alloc_block();
-            //     vfs_seek(harddrive, double_ptrs[l2] * BLOCK_SIZE, VFS_BEG);
-            //     vfs_write(harddrive, single_ptrs, BLOCK_SIZE);
-            // }
-            //
-            // real_block = single_ptrs[l3];
-        }
-
-        if (real_block == 0 || real_block == 0xFFFFFFFF) {
+        uint32_t real_block = get_real_block(blocks, (pos + i * BLOCK_SIZE) / BLOCK_SIZE, 1);
+        if (real_block == 0) {
             return; // out of space
         }
-
-        vfs_seek(harddrive, real_block * BLOCK_SIZE, VFS_BEG);
-        vfs_write(harddrive, (uint8_t*)buffer + (i * BLOCK_SIZE), BLOCK_SIZE);
+        block_cache_write(harddrive, real_block * BLOCK_SIZE, (uint8_t*)buffer + (i * BLOCK_SIZE), BLOCK_SIZE);
     }
 }
 
-#define BUFFER_SIZE_BLOCKS 5
-
+// files don't buffer anything themselves, the data is copied from and to the block cache
 VFSFile* fs_open(VFSIndexNode* inode)
 {
     VFSFile* file = (VFSFile*)malloc(sizeof(VFSFile));
     if (file == NULL) {
         return NULL;
     }
-    file->inode = inode;
-    file->private_data = malloc(sizeof(struct FileData));
-    file->private_data_size = 0;
-    file->position = 0;
-    if (file->private_data == NULL) {
-        free(file);
-        return NULL;
-    }
-    struct FileData* fd = file->private_data;
-    fd->range_low = 0;
-    fd->range_high = 0;
-    fd->data = malloc(BLOCK_SIZE * BUFFER_SIZE_BLOCKS);
-    if (fd->data == NULL) {
-        free(file->private_data);
+    struct FileData* data = (struct FileData*)malloc(sizeof(struct FileData));
+    if (data == NULL) {
         free(file);
         return NULL;
     }
+    data->written = 0;
+    file->inode = inode;
+    file->private_data = data;
+    file->private_data_size = sizeof(struct FileData);
+    file->position = 0;
     return file;
 }
 
 void fs_close(VFSFile* file)
 {
-    if (file->private_data != NULL) {
-        free(file->private_data);
+    if (((struct FileData*)file->private_data)->written) {
+        block_cache_sync(harddrive);
     }
+    free(file->private_data);
     free(file);
 }
 
-uint32_t fs_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+uint32_t fs_readv(VFSFile* file, VFSIOVector* vectors, uint32_t count)
 {
-    if (buffer_size == 0) {
-        return 0;
-    }
-    if (file->position >= file->inode->size) {
-        return 0;
-    }
-    if (buffer_size + file->position > file->inode->size) {
-        buffer_size = file->inode->size - file->position;
-    }
-
-    struct FileData* fd = file->private_data;
     struct InodeData* id = file->inode->private_data;
-
-    uint32_t remaining_size = buffer_size;
     uint32_t bytes_read = 0;
-    while (remaining_size > 0) {
-        if (remaining_size > BUFFER_SIZE_BLOCKS * BLOCK_SIZE) {
-            buffer_size = BUFFER_SIZE_BLOCKS * BLOCK_SIZE;
-        }
-        remaining_size -= buffer_size;
-
-        if (file->position + buffer_size > fd->range_high || file->position < fd->range_low || fd->range_high == fd->range_low) {
-            void* temp = harddrive_load_blocks(fd->data, id->blocks, file->position, BUFFER_SIZE_BLOCKS);
-            if (temp == NULL) {
-                return 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t done = 0;
+        while (done < vectors[i].length && file->position < file->inode->size) {
+            uint32_t block_offset = file->position % BLOCK_SIZE;
+            uint32_t length = vectors[i].length - done;
+            if (length > BLOCK_SIZE - block_offset) {
+                length = BLOCK_SIZE - block_offset;
             }
-            fd->data = temp;
-
-            fd->range_low = (file->position / BLOCK_SIZE) * BLOCK_SIZE;
-            fd->range_high = fd->range_low + (BUFFER_SIZE_BLOCKS * BLOCK_SIZE);
+            if (length > file->inode->size - file->position) {
+                length = file->inode->size - file->position;
+            }
+            uint32_t real_block = get_real_block(id->blocks, file->position / BLOCK_SIZE, 0);
+            if (real_block == 0 || block_cache_read(harddrive, real_block * BLOCK_SIZE + block_offset, (uint8_t*)vectors[i].buffer + done, length) != 0) {
+                return bytes_read;
+            }
+            file->position += length;
+            done += length;
+            bytes_read += length;
         }
-
-        uint32_t i;
-        for (i = 0; i < buffer_size; i++) {
-            ((uint8_t*)buffer)[i] = fd->data[i + file->position - fd->range_low];
+        if (done < vectors[i].length) {
+            break;
         }
-        file->position += i;
-        bytes_read += i;
     }
     return bytes_read;
 }
 
-uint32_t fs_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+// the blocks stay dirty in the cache until the file is flushed or closed, the inode is written once at the end
+uint32_t fs_writev(VFSFile* file, VFSIOVector* vectors, uint32_t count)
 {
-    struct FileData* fd = file->private_data;
     struct InodeData* id = file->inode->private_data;
-    if (file->position + buffer_size > fd->range_high || file->position < fd->range_low || fd->range_high == fd->range_low) {
-        if (file->inode->size == 0) {
-
-            fd->data = malloc(BLOCK_SIZE * 5);
-
-        } else {
-
-            fd->data = harddrive_load_blocks(fd->data, id->blocks, file->position, 5);
-            if (fd->data == NULL) {
-                return 0;
+    uint32_t bytes_written = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t done = 0;
+        while (done < vectors[i].length) {
+            uint32_t block_offset = file->position % BLOCK_SIZE;
+            uint32_t length = vectors[i].length - done;
+            if (length > BLOCK_SIZE - block_offset) {
+                length = BLOCK_SIZE - block_offset;
             }
+            uint32_t real_block = get_real_block(id->blocks, file->position / BLOCK_SIZE, 1);
+            if (real_block == 0 || block_cache_write(harddrive, real_block * BLOCK_SIZE + block_offset, (uint8_t*)vectors[i].buffer + done, length) != 0) {
+                break; // out of space
+            }
+            file->position += length;
+            if (file->position > file->inode->size) {
+                file->inode->size = file->position;
+            }
+            done += length;
+            bytes_written += length;
+        }
+        if (done < vectors[i].length) {
+            break;
         }
-
-        fd->range_low = (file->position / BLOCK_SIZE) * BLOCK_SIZE;
-        fd->range_high = fd->range_low + (5 * BLOCK_SIZE);
-    }
-
-    uint32_t i;
-    for (i = 0; i < buffer_size; i++) {
-        fd->data[i + file->position - fd->range_low] = ((uint8_t*)buffer)[i];
     }
-    file->position += i;
-    if (file->position > file->inode->size) {
-        file->inode->size = file->position;
+    if (bytes_written != 0) {
+        write_inode(vfstofs(file->inode), id->inode_number);
+        ((struct FileData*)file->private_data)->written = 1;
     }
-    uint32_t number_to_write = 5;
-    if (number_to_write > (file->inode->size / BLOCK_SIZE) + 1) {
-        number_to_write = (file->inode->size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    return bytes_written;
+}
+
+uint32_t fs_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    VFSIOVector vector = { .buffer = buffer, .length = buffer_size };
+    return fs_readv(file, &vector, 1);
+}
+
+uint32_t fs_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    VFSIOVector vector = { .buffer = buffer, .length = buffer_size };
+    return fs_writev(file, &vector, 1);
+}
+
+// the blocks are written to out from the cached pages they're in
+uint32_t fs_transfer(VFSFile* file, VFSFile* out, uint32_t length)
+{
+    struct InodeData* id = file->inode->private_data;
+    uint32_t moved = 0;
+    while (moved < length && file->position < file->inode->size) {
+        uint32_t block_offset = file->position % BLOCK_SIZE;
+        uint32_t part = length - moved;
+        if (part > BLOCK_SIZE - block_offset) {
+            part = BLOCK_SIZE - block_offset;
+        }
+        if (part > file->inode->size - file->position) {
+            part = file->inode->size - file->position;
+        }
+        // blocks never cross a cache page
+        uint32_t real_block = get_real_block(id->blocks, file->position / BLOCK_SIZE, 0);
+        uint32_t offset = real_block * BLOCK_SIZE + block_offset;
+        uint8_t* data = real_block == 0 ? NULL : block_cache_pin(harddrive, offset);
+        if (data == NULL) {
+            break;
+        }
+        uint32_t written = vfs_write(out, data, part);
+        block_cache_unpin(harddrive, offset);
+        file->position += written;
+        moved += written;
+        if (written < part) {
+            break;
+        }
     }
-    harddrive_write_blocks(fd->data, id->blocks, fd->range_low, number_to_write);
+    return moved;
+}
 
-    write_inode(vfstofs(file->inode), id->inode_number);
+// writes and reads that only need cached blocks are done right away, other reads wait for the disk on the io queue thread
+// writes allocate blocks and change the inode, so one that has to wait behind a request of the file runs with kernel_lock
+uint8_t fs_submit(VFSFile* file, VFSRequest* request)
+{
+    struct InodeData* id = file->inode->private_data;
+    // a queued request of the file still has to move the position first
+    if (request->write) {
+        return io_queue_busy(file) ? io_queue_push(request, IO_QUEUE_KERNEL_LOCK) : 1;
+    }
+    if (!io_queue_busy(file)) {
+        uint32_t end = file->position;
+        if (file->position < file->inode->size) {
+            end += request->length < file->inode->size - file->position ? request->length : file->inode->size - file->position;
+        }
 
-    return i;
+        // only the direct blocks can be found without reading a pointer block
+        uint8_t cached = end == file->position || (end - 1) / BLOCK_SIZE < NUM_DIRECT_BLOCKS;
+        for (uint32_t block = file->position / BLOCK_SIZE; cached && end != file->position && block <= (end - 1) / BLOCK_SIZE; block++) {
+            cached = id->blocks[block] != 0 && block_cache_contains(harddrive, id->blocks[block] * BLOCK_SIZE, BLOCK_SIZE);
+        }
+        if (cached) {
+            vfs_complete_request(request, fs_read(file, request->buffer, request->length));
+            return 0;
+        }
+    }
+    return io_queue_push(request, 0);
 }
 
 void fs_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg) { }
@@ -490,7 +420,11 @@ uint32_t fs_tell(VFSFile* file)
 {
     return file->position;
 }
-void fs_flush(VFSFile* file) { }
+void fs_flush(VFSFile* file)
+{
+    (void)file;
+    block_cache_sync(harddrive);
+}
 
 VFSFileOperations get_fs_file_operations()
 {
@@ -503,6 +437,10 @@ VFSFileOperations get_fs_file_operations()
         .seek = (void*)fs_seek,
         .tell = (void*)fs_tell,
         .flush = (void*)fs_flush,
+        .readv = (void*)fs_readv,
+        .writev = (void*)fs_writev,
+        .submit = (void*)fs_submit,
+        .transfer = (void*)fs_transfer,
     };
     return fops;
 }
@@ -512,12 +450,8 @@ struct Inode fetch_inode(uint32_t inode_number)
     uint32_t inode_offset = ((SUPER_BLOCK_OFFSET + BLOCK_SIZE + BLOCK_BP_SIZE + INODE_BP_SIZE) / BLOCK_SIZE + 1) * BLOCK_SIZE
         + (inode_number * INODE_SIZE);
 
-    uint8_t buffer[512];
-    vfs_seek(harddrive, inode_offset, VFS_BEG);
-    vfs_read(harddrive, buffer, 512);
-    uint32_t sub_offset = inode_number % 8;
-    struct Inode inode;
-    memcpy(&inode, &buffer[sub_offset * INODE_SIZE], INODE_SIZE);
+    struct Inode inode = { 0 };
+    block_cache_read(harddrive, inode_offset, &inode, INODE_SIZE);
     return inode;
 }
 
@@ -531,8 +465,7 @@ struct DirectoryEntry* fetch_inode_directory(struct Inode inode)
         return NULL;
     }
     memset(entries, 0, (inode.size / 512 + 1) * 512);
-    vfs_seek(harddrive, inode.blocks[0] * BLOCK_SIZE, VFS_BEG);
-    vfs_read(harddrive, entries, (inode.size / 512 + 1) * 512);
+    block_cache_read(harddrive, inode.blocks[0] * BLOCK_SIZE, entries, (inode.size / 512 + 1) * 512);
 
     return entries;
 }
@@ -654,32 +587,14 @@ uint32_t resolve_inode_number(char* path)
     return inode_number;
 }
 
-int create_inode(char* path, char* name, VFSFileType type)
+// the vfs checked that the name isn't used yet, the cached directory inode is updated with the disk one
+int create_inode(VFSIndexNode* directory, char* name, VFSFileType type)
 {
-    struct Inode inode = resolve_inode(path);
-
-    if (inode.type != DIRECTORY) {
+    if (directory->type != VFS_DIRECTORY) {
         return 1;
     }
-
-    char* full_path = malloc(strlen(path) + 1 + strlen(name) + 1);
-
-    if (strlen(path) <= 1) {
-        full_path[strlen(path) + strlen(name)] = '\0';
-        strncpy(full_path, path, strlen(path));
-        strncpy(full_path + strlen(path), name, strlen(name));
-    } else {
-        full_path[strlen(path) + 1 + strlen(name)] = '\0';
-        strncpy(full_path, path, strlen(path));
-        full_path[strlen(path)] = '/';
-        strncpy(full_path + strlen(path) + 1, name, strlen(name));
-    }
-
-    if (resolve_inode(full_path).type != 0) {
-        return 1; // already exists
-    }
-
-    free(full_path);
+    struct InodeData* id = directory->private_data;
+    struct Inode inode = vfstofs(directory);
 
     struct DirectoryEntry* new_entry = malloc(sizeof(struct DirectoryEntry) + strlen(name));
 
@@ -708,7 +623,9 @@ int create_inode(char* path, char* name, VFSFileType type)
     harddrive_write_blocks(dir_buffer, inode.blocks, inode.size, 2);
 
     inode.size += new_entry->entry_length;
-    write_inode(inode, resolve_inode_number(path));
+    write_inode(inode, id->inode_number);
+    directory->size = inode.size;
+    memcpy(id->blocks, inode.blocks, sizeof(uint32_t) * 13);
 
     struct Inode new_inode = {
         .type = type,
@@ -717,6 +634,7 @@ int create_inode(char* path, char* name, VFSFileType type)
     };
 
     write_inode(new_inode, new_entry->inode_number);
+    block_cache_sync(harddrive);
 
     free(new_entry);
 
@@ -738,6 +656,30 @@ VFSIndexNode get_inode(char* path)
     return vfs_inode;
 }
 
+// reads only the directory, the path before it was resolved by the vfs
+VFSIndexNode lookup(VFSIndexNode* directory, char* name)
+{
+    VFSIndexNode vfs_inode = { 0 };
+    vfs_inode.type = VFS_ERROR;
+    if (directory->type != VFS_DIRECTORY) {
+        return vfs_inode;
+    }
+    struct DirectoryEntry* base_entry = fetch_inode_directory(vfstofs(directory));
+    if (base_entry == NULL) {
+        return vfs_inode;
+    }
+    uint32_t name_length = strlen(name);
+    for (struct DirectoryEntry* entry = base_entry; entry->entry_length != 0; entry = (struct DirectoryEntry*)((uint8_t*)entry + entry->entry_length)) {
+        if (entry->name_length == name_length && strncmp(entry->name, name, name_length) == 0) {
+            uint32_t inode_number = entry->inode_number;
+            free(base_entry);
+            return fstovfs(fetch_inode(inode_number), inode_number);
+        }
+    }
+    free(base_entry);
+    return vfs_inode;
+}
+
 VFSDirectory* get_directory(char* path, VFSIndexNode* inode)
 {
     if (inode->type != VFS_DIRECTORY) {
@@ -797,6 +739,59 @@ VFSDirectory* get_directory(char* path, VFSIndexNode* inode)
     return vfs_dir;
 }
 
+// copies length bytes at offset of the data of an inode, returns 1 if a block is missing or can't be read
+static uint8_t read_inode_data(uint32_t blocks[13], uint32_t offset, void* buffer, uint32_t length)
+{
+    while (length > 0) {
+        uint32_t block_offset = offset % BLOCK_SIZE;
+        uint32_t part = length < BLOCK_SIZE - block_offset ? length : BLOCK_SIZE - block_offset;
+        uint32_t real_block = get_real_block(blocks, offset / BLOCK_SIZE, 0);
+        if (real_block == 0 || block_cache_read(harddrive, real_block * BLOCK_SIZE + block_offset, buffer, part) != 0) {
+            return 1;
+        }
+        buffer = (uint8_t*)buffer + part;
+        offset += part;
+        length -= part;
+    }
+    return 0;
+}
+
+// the cookie is the offset of the next entry in the directory data, names are read straight into the records
+uint32_t get_directory_entries(VFSIndexNode* directory, uint32_t* cookie, void* buffer, uint32_t buffer_size)
+{
+    struct InodeData* id = directory->private_data;
+    uint32_t used = 0;
+    while (*cookie < directory->size) {
+        struct DirectoryEntry entry;
+        // a read error leaves the cookie at the entry so it isn't taken for the end of the directory
+        if (read_inode_data(id->blocks, *cookie, &entry, sizeof(struct DirectoryEntry)) != 0) {
+            return used;
+        }
+        if (entry.entry_length == 0) {
+            break;
+        }
+        uint32_t record_length = VFS_DIRECTORY_RECORD_LENGTH(entry.name_length);
+        if (buffer_size - used < record_length) {
+            return used;
+        }
+        VFSDirectoryRecord* record = (VFSDirectoryRecord*)((uint8_t*)buffer + used);
+        if (read_inode_data(id->blocks, *cookie + sizeof(struct DirectoryEntry), record->name, entry.name_length) != 0) {
+            return used;
+        }
+        record->name[entry.name_length] = '\0';
+        struct Inode inode = fetch_inode(entry.inode_number);
+        record->inode_number = entry.inode_number;
+        record->type = inode.type;
+        record->size = inode.size;
+        record->record_length = record_length;
+        record->name_length = entry.name_length;
+        used += record_length;
+        *cookie += entry.entry_length;
+    }
+    *cookie = VFS_DIRECTORY_COOKIE_END;
+    return used;
+}
+
 void free_inode_data(VFSIndexNode inode)
 {
     free(inode.private_data);
@@ -808,7 +803,9 @@ VFSDriverOperations get_fs_driver_operations()
     VFSDriverOperations dops = {
         .create_inode = create_inode,
         .get_inode = get_inode,
+        .lookup = lookup,
         .get_directory = get_directory,
+        .get_directory_entries = get_directory_entries,
         .free_inode_data = free_inode_data,
     };
     return dops;
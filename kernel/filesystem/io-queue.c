@@ -0,0 +1,168 @@
+#include "io-queue.h"
+#include <heap.h>
+#include <memutils.h>
+#include <pager.h>
+#include <print.h>
+#include <process.h>
+#include <spinlock.h>
+
+VFSRequest* io_queue_first = NULL;
+VFSRequest* io_queue_last = NULL;
+uint32_t io_queue_thread = PROCESS_INVALID_ID;
+// the request the thread is running, set to NULL by io_queue_cancel
+VFSRequest* io_queue_running = NULL;
+
+// with the request's page table loaded and interrupts off, so the thread isn't switched out with the other table loaded
+static uint32_t run_in_place(VFSRequest* request)
+{
+    PDETable* own_table = get_loaded_page_table();
+    load_page_table(request->page_table);
+    VFSFileOperations* fops = &request->file->inode->file_operations;
+    uint32_t result = request->write ? fops->write(request->file, request->buffer, request->length)
+                                     : fops->read(request->file, request->buffer, request->length);
+    load_page_table(own_table);
+    return result;
+}
+
+// called and returns with kernel_lock held, the request may be cancelled while the lock is dropped
+static uint32_t run_request(VFSRequest* request)
+{
+    uint8_t* buffer = (request->queue_flags & IO_QUEUE_KERNEL_LOCK) ? NULL : malloc(request->length);
+    if (buffer == NULL) {
+        return run_in_place(request);
+    }
+    VFSFile* file = request->file;
+    uint32_t length = request->length;
+    uint8_t write = request->write;
+    PDETable* own_table = get_loaded_page_table();
+    if (write) {
+        load_page_table(request->page_table);
+        memcpy(buffer, request->buffer, length);
+        load_page_table(own_table);
+    }
+
+    spin_unlock(&kernel_lock);
+    __asm__("sti\n");
+    uint32_t result = write ? file->inode->file_operations.write(file, buffer, length)
+                            : file->inode->file_operations.read(file, buffer, length);
+    __asm__("cli\n");
+    spin_lock(&kernel_lock);
+
+    if (!write && io_queue_running == request) {
+        load_page_table(request->page_table);
+        memcpy(request->buffer, buffer, result);
+        load_page_table(own_table);
+    }
+    free(buffer);
+    return result;
+}
+
+// entry of the thread, it suspends itself while the queue is empty and io_queue_push wakes it
+void io_queue_run()
+{
+    struct process* self = get_current_process();
+    while (1) {
+        uint32_t eflags = spin_lock_irqsave(&kernel_lock);
+        VFSRequest* request = io_queue_first;
+        if (request == NULL) {
+            self->state = PROCESS_SUSPENDED;
+        } else {
+            io_queue_first = request->next;
+            if (io_queue_first == NULL) {
+                io_queue_last = NULL;
+            }
+            request->next = NULL;
+
+            io_queue_running = request;
+            uint32_t result = run_request(request);
+            if (io_queue_running == request) {
+                io_queue_running = NULL;
+                vfs_complete_request(request, result);
+            }
+        }
+        spin_unlock_irqrestore(&kernel_lock, eflags);
+
+        if (self->state != PROCESS_RUNNING) {
+            yield_process();
+        }
+    }
+}
+
+int io_queue_init()
+{
+    // the stack comes from the heap since it's mapped in every page table the thread loads
+    uint8_t* stack = malloc(IO_QUEUE_STACK_SIZE);
+    if (stack == NULL) {
+        printf("Failed to allocate stack for the io queue\n");
+        return 1;
+    }
+    uint32_t stack_base = (uint32_t)stack + IO_QUEUE_STACK_SIZE - 16;
+    struct process* thread = create_process("io-queue", PROCESS_SUSPENDED, (uint32_t)io_queue_run, stack_base, stack_base,
+        kernel_table, NULL, NULL, NULL, 0, 0);
+    if (thread == NULL) {
+        free(stack);
+        return 1;
+    }
+    io_queue_thread = thread->id;
+    return 0;
+}
+
+uint8_t io_queue_push(VFSRequest* request, uint8_t flags)
+{
+    struct process* thread = io_queue_thread == PROCESS_INVALID_ID ? NULL : find_process(io_queue_thread);
+    if (thread == NULL) {
+        return 1;
+    }
+
+    request->next = NULL;
+    request->queue_flags = flags;
+    if (io_queue_last != NULL) {
+        io_queue_last->next = request;
+    } else {
+        io_queue_first = request;
+    }
+    io_queue_last = request;
+
+    if (thread->state == PROCESS_SUSPENDED) {
+        wake_process(thread);
+    }
+    return 0;
+}
+
+uint8_t io_queue_busy(VFSFile* file)
+{
+    if (io_queue_running != NULL && io_queue_running->file == file) {
+        return 1;
+    }
+    for (VFSRequest* queued = io_queue_first; queued != NULL; queued = queued->next) {
+        if (queued->file == file) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint8_t io_queue_cancel(VFSRequest* request)
+{
+    if (io_queue_running == request) {
+        io_queue_running = NULL;
+        return 0;
+    }
+    VFSRequest* previous = NULL;
+    for (VFSRequest* queued = io_queue_first; queued != NULL; previous = queued, queued = queued->next) {
+        if (queued != request) {
+            continue;
+        }
+        if (previous != NULL) {
+            previous->next = request->next;
+        } else {
+            io_queue_first = request->next;
+        }
+        if (io_queue_last == request) {
+            io_queue_last = previous;
+        }
+        request->next = NULL;
+        return 0;
+    }
+    return 1;
+}
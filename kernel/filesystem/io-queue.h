@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+// VFSRequests of the disk drivers run one at a time on a kernel thread, the process that submitted one keeps running meanwhile
+// the transfer runs without kernel_lock and with interrupts on, through a heap buffer that is copied from or into the
+// page table the request was submitted from, the driver has to lock the device itself
+// requests that don't fit in the heap run in place with kernel_lock held
+// the functions are used with kernel_lock held like the rest of the vfs
+#define IO_QUEUE_STACK_SIZE 0x1000
+
+enum {
+    // the request changes state kernel_lock protects, it always runs in place with the lock held
+    IO_QUEUE_KERNEL_LOCK = 1,
+};
+
+// starts the thread, expects the process table to be set up, returns 0 on success
+int io_queue_init();
+
+// for the submit operation of a driver, flags are IO_QUEUE_*, returns 1 if there is no thread to run the request
+uint8_t io_queue_push(VFSRequest* request, uint8_t flags);
+// returns 1 if a request of the file is waiting in the queue or running
+uint8_t io_queue_busy(VFSFile* file);
+// takes a request out of the queue, a running one is finished without touching the request again
+// returns 1 if it wasn't queued or running
+uint8_t io_queue_cancel(VFSRequest* request);
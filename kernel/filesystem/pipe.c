@@ -0,0 +1,206 @@
+#include "pipe.h"
+#include <heap.h>
+#include <memutils.h>
+#include <process.h>
+#include <spinlock.h>
+
+// a blocked end checks again after this long in case it was woken for another waiter
+#define PIPE_WAIT_NS 10000000ull
+
+struct pipe {
+    // the ends have their own inodes so the file operations know which one they were called on
+    VFSIndexNode read_inode;
+    VFSIndexNode write_inode;
+    uint8_t read_open;
+    uint8_t write_open;
+    uint32_t head; // advanced by the reader, both run freely and are masked with PIPE_SIZE - 1
+    uint32_t tail; // advanced by the writer
+    uint32_t reader; // thread waiting for data, PROCESS_INVALID_ID if none
+    uint32_t writer; // thread waiting for space
+    uint8_t data[PIPE_SIZE];
+};
+
+_Static_assert((PIPE_SIZE & (PIPE_SIZE - 1)) == 0, "pipe size has to be a power of two");
+
+static void wake(uint32_t* waiter)
+{
+    if (*waiter == PROCESS_INVALID_ID) {
+        return;
+    }
+    struct process* process = find_process(*waiter);
+    if (process != NULL && process->state == PROCESS_SLEEPING) {
+        wake_process(process);
+    }
+    *waiter = PROCESS_INVALID_ID;
+}
+
+// returns 0 if the caller can check the pipe again, 1 if the process is going away
+static uint8_t wait(uint32_t* waiter)
+{
+    struct process* self = get_current_process();
+    *waiter = self->id;
+    sleep_process(self, PIPE_WAIT_NS);
+    spin_unlock(&kernel_lock);
+    yield_process();
+    spin_lock(&kernel_lock);
+    return self->state != PROCESS_RUNNING;
+}
+
+static void update_size(struct pipe* pipe)
+{
+    pipe->read_inode.size = pipe->tail - pipe->head;
+    pipe->write_inode.size = pipe->read_inode.size;
+}
+
+uint32_t pipe_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    struct pipe* pipe = file->private_data;
+    if (file->inode != &pipe->read_inode || buffer_size == 0) {
+        return 0;
+    }
+    while (pipe->tail == pipe->head) {
+        if (!pipe->write_open || wait(&pipe->reader) != 0) {
+            return 0;
+        }
+    }
+
+    uint32_t length = pipe->tail - pipe->head;
+    if (length > buffer_size) {
+        length = buffer_size;
+    }
+    for (uint32_t done = 0; done < length;) {
+        uint32_t offset = pipe->head & (PIPE_SIZE - 1);
+        uint32_t part = PIPE_SIZE - offset < length - done ? PIPE_SIZE - offset : length - done;
+        memcpy((uint8_t*)buffer + done, pipe->data + offset, part);
+        pipe->head += part;
+        done += part;
+    }
+    update_size(pipe);
+    wake(&pipe->writer);
+    return length;
+}
+
+uint32_t pipe_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    struct pipe* pipe = file->private_data;
+    if (file->inode != &pipe->write_inode) {
+        return 0;
+    }
+    uint32_t done = 0;
+    while (done < buffer_size && pipe->read_open) {
+        uint32_t space = PIPE_SIZE - (pipe->tail - pipe->head);
+        if (space == 0) {
+            if (wait(&pipe->writer) != 0) {
+                break;
+            }
+            continue;
+        }
+        uint32_t offset = pipe->tail & (PIPE_SIZE - 1);
+        uint32_t part = buffer_size - done;
+        if (part > space) {
+            part = space;
+        }
+        if (part > PIPE_SIZE - offset) {
+            part = PIPE_SIZE - offset;
+        }
+        memcpy(pipe->data + offset, (uint8_t*)buffer + done, part);
+        pipe->tail += part;
+        done += part;
+        update_size(pipe);
+        wake(&pipe->reader);
+    }
+    return done;
+}
+
+void pipe_close(VFSFile* file)
+{
+    struct pipe* pipe = file->private_data;
+    if (file->inode == &pipe->read_inode) {
+        pipe->read_open = 0;
+        wake(&pipe->writer);
+    } else {
+        pipe->write_open = 0;
+        wake(&pipe->reader);
+    }
+    free(file);
+    if (!pipe->read_open && !pipe->write_open) {
+        free(pipe);
+    }
+}
+
+void pipe_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg)
+{
+    (void)file;
+    (void)command;
+    (void)arg;
+}
+
+void pipe_seek(VFSFile* file, uint32_t offset, VFSWhence whence)
+{
+    (void)file;
+    (void)offset;
+    (void)whence;
+}
+
+uint32_t pipe_tell(VFSFile* file)
+{
+    (void)file;
+    return 0;
+}
+
+void pipe_flush(VFSFile* file)
+{
+    (void)file;
+}
+
+static VFSFile* open_end(struct pipe* pipe, VFSIndexNode* inode)
+{
+    VFSFile* file = malloc(sizeof(VFSFile));
+    if (file == NULL) {
+        return NULL;
+    }
+    file->inode = inode;
+    file->private_data = pipe;
+    file->private_data_size = 0;
+    file->position = 0;
+    return file;
+}
+
+int pipe_create(VFSFile** read_end, VFSFile** write_end)
+{
+    struct pipe* pipe = malloc(sizeof(struct pipe));
+    if (pipe == NULL) {
+        return 1;
+    }
+    memset(pipe, 0, sizeof(struct pipe) - PIPE_SIZE);
+
+    // the inodes have no dentry, the vfs leaves them to the pipe
+    VFSFileOperations fops = {
+        .read = (void*)pipe_read,
+        .write = (void*)pipe_write,
+        .close = (void*)pipe_close,
+        .ioctl = (void*)pipe_ioctl,
+        .seek = (void*)pipe_seek,
+        .tell = (void*)pipe_tell,
+        .flush = (void*)pipe_flush,
+    };
+    pipe->read_inode.type = VFS_PIPE;
+    pipe->read_inode.file_operations = fops;
+    pipe->read_inode.private_data = pipe;
+    pipe->read_inode.number_of_references = 1;
+    pipe->write_inode = pipe->read_inode;
+    pipe->reader = PROCESS_INVALID_ID;
+    pipe->writer = PROCESS_INVALID_ID;
+
+    *read_end = open_end(pipe, &pipe->read_inode);
+    *write_end = open_end(pipe, &pipe->write_inode);
+    if (*read_end == NULL || *write_end == NULL) {
+        free(*read_end);
+        free(*write_end);
+        free(pipe);
+        return 1;
+    }
+    pipe->read_open = 1;
+    pipe->write_open = 1;
+    return 0;
+}
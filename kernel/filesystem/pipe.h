@@ -0,0 +1,13 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+// anonymous pipe, a ring buffer with a read end and a write end that only exist as open files
+// reading an empty pipe blocks until something is written or every write end is closed, then it returns 0
+// writing blocks until everything fit or the read end is closed
+// the ends are used with kernel_lock held, it's dropped while they wait
+#define PIPE_SIZE 0x1000
+
+// returns 0 on success, the ends are closed with vfs_close_file and the pipe is freed with the last one
+int pipe_create(VFSFile** read_end, VFSFile** write_end);
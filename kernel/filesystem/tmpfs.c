@@ -0,0 +1,431 @@
+#include "tmpfs.h"
+#include <heap.h>
+#include <memutils.h>
+#include <spinlock.h>
+
+struct tmpfs_entry;
+
+// the node outlives the inodes the vfs caches for it, their private data points here
+struct tmpfs_node {
+    uint32_t number;
+    uint32_t type;
+    uint32_t size; // bytes of a file, entries of a directory
+    uint8_t** pages; // NULL for pages that were never written, they read as zeroes
+    uint32_t number_of_pages;
+    struct tmpfs_entry* entries; // in the order they were made in
+    struct tmpfs_entry* last_entry;
+    // protects the pages and the size, reads run without kernel_lock while writes change them
+    spinlock_t lock;
+};
+
+struct tmpfs_entry {
+    struct tmpfs_node* node;
+    struct tmpfs_entry* next;
+    uint32_t name_length;
+    char name[];
+};
+
+struct tmpfs_node tmpfs_root = {
+    .number = 1,
+    .type = VFS_DIRECTORY,
+    .lock = SPINLOCK_INIT,
+};
+uint32_t tmpfs_next_number = 2;
+uint32_t tmpfs_used_pages = 0;
+
+static VFSIndexNode to_vfs(struct tmpfs_node* node)
+{
+    VFSIndexNode inode = {
+        .type = node->type,
+        .size = node->size,
+        .file_operations = get_tmpfs_file_operations(),
+        .private_data = node,
+        .number_of_references = 0,
+    };
+    return inode;
+}
+
+static VFSIndexNode error_inode()
+{
+    VFSIndexNode inode = { 0 };
+    inode.type = VFS_ERROR;
+    return inode;
+}
+
+// returns the page that holds byte index * TMPFS_PAGE_SIZE of the node, NULL once the budget or the heap is used up
+static uint8_t* get_page(struct tmpfs_node* node, uint32_t index)
+{
+    if (index >= node->number_of_pages) {
+        uint8_t** pages = node->pages == NULL
+            ? (uint8_t**)malloc(sizeof(uint8_t*) * (index + 1))
+            : (uint8_t**)realloc(node->pages, sizeof(uint8_t*) * (index + 1));
+        if (pages == NULL) {
+            return NULL;
+        }
+        memset(pages + node->number_of_pages, 0, sizeof(uint8_t*) * (index + 1 - node->number_of_pages));
+        node->pages = pages;
+        node->number_of_pages = index + 1;
+    }
+    if (node->pages[index] == NULL && tmpfs_used_pages < TMPFS_PAGES) {
+        node->pages[index] = malloc(TMPFS_PAGE_SIZE);
+        if (node->pages[index] != NULL) {
+            memset(node->pages[index], 0, TMPFS_PAGE_SIZE);
+            tmpfs_used_pages++;
+        }
+    }
+    return node->pages[index];
+}
+
+// the part of the page at the position of file that is still in the file, at most length bytes
+static uint32_t page_part(VFSFile* file, uint32_t length)
+{
+    uint32_t page_offset = file->position % TMPFS_PAGE_SIZE;
+    if (length > TMPFS_PAGE_SIZE - page_offset) {
+        length = TMPFS_PAGE_SIZE - page_offset;
+    }
+    return length;
+}
+
+VFSFile* tmpfs_open(VFSIndexNode* inode)
+{
+    VFSFile* file = (VFSFile*)malloc(sizeof(VFSFile));
+    if (file == NULL) {
+        return NULL;
+    }
+    file->inode = inode;
+    file->private_data = NULL;
+    file->private_data_size = 0;
+    file->position = 0;
+    return file;
+}
+
+void tmpfs_close(VFSFile* file)
+{
+    free(file);
+}
+
+uint32_t tmpfs_readv(VFSFile* file, VFSIOVector* vectors, uint32_t count)
+{
+    struct tmpfs_node* node = file->inode->private_data;
+    uint32_t bytes_read = 0;
+    uint32_t eflags = spin_lock_irqsave(&node->lock);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t done = 0;
+        while (done < vectors[i].length && file->position < node->size) {
+            uint32_t length = page_part(file, vectors[i].length - done);
+            if (length > node->size - file->position) {
+                length = node->size - file->position;
+            }
+            uint32_t index = file->position / TMPFS_PAGE_SIZE;
+            uint8_t* page = index < node->number_of_pages ? node->pages[index] : NULL;
+            if (page == NULL) {
+                memset((uint8_t*)vectors[i].buffer + done, 0, length);
+            } else {
+                memcpy((uint8_t*)vectors[i].buffer + done, page + file->position % TMPFS_PAGE_SIZE, length);
+            }
+            file->position += length;
+            done += length;
+            bytes_read += length;
+        }
+        if (done < vectors[i].length) {
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&node->lock, eflags);
+    return bytes_read;
+}
+
+uint32_t tmpfs_writev(VFSFile* file, VFSIOVector* vectors, uint32_t count)
+{
+    struct tmpfs_node* node = file->inode->private_data;
+    uint32_t bytes_written = 0;
+    uint32_t eflags = spin_lock_irqsave(&node->lock);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t done = 0;
+        while (done < vectors[i].length) {
+            uint32_t length = page_part(file, vectors[i].length - done);
+            uint8_t* page = get_page(node, file->position / TMPFS_PAGE_SIZE);
+            if (page == NULL) {
+                break; // out of space
+            }
+            memcpy(page + file->position % TMPFS_PAGE_SIZE, (uint8_t*)vectors[i].buffer + done, length);
+            file->position += length;
+            if (file->position > node->size) {
+                node->size = file->position;
+                file->inode->size = node->size;
+            }
+            done += length;
+            bytes_written += length;
+        }
+        if (done < vectors[i].length) {
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&node->lock, eflags);
+    return bytes_written;
+}
+
+uint32_t tmpfs_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    VFSIOVector vector = { .buffer = buffer, .length = buffer_size };
+    return tmpfs_readv(file, &vector, 1);
+}
+
+uint32_t tmpfs_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    VFSIOVector vector = { .buffer = buffer, .length = buffer_size };
+    return tmpfs_writev(file, &vector, 1);
+}
+
+// the pages are written to out where they are, pages are never freed so the lock is only held while one is looked up
+uint32_t tmpfs_transfer(VFSFile* file, VFSFile* out, uint32_t length)
+{
+    static uint8_t zeroes[TMPFS_PAGE_SIZE] = { 0 };
+    struct tmpfs_node* node = file->inode->private_data;
+    uint32_t moved = 0;
+    while (moved < length) {
+        uint32_t eflags = spin_lock_irqsave(&node->lock);
+        uint32_t part = 0;
+        uint8_t* page = NULL;
+        if (file->position < node->size) {
+            part = page_part(file, length - moved);
+            if (part > node->size - file->position) {
+                part = node->size - file->position;
+            }
+            uint32_t index = file->position / TMPFS_PAGE_SIZE;
+            page = index < node->number_of_pages ? node->pages[index] : NULL;
+        }
+        spin_unlock_irqrestore(&node->lock, eflags);
+        if (part == 0) {
+            break;
+        }
+        uint32_t written = vfs_write(out, page == NULL ? zeroes : page + file->position % TMPFS_PAGE_SIZE, part);
+        file->position += written;
+        moved += written;
+        if (written < part) {
+            break;
+        }
+    }
+    return moved;
+}
+
+void tmpfs_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg)
+{
+    (void)file;
+    (void)command;
+    (void)arg;
+}
+
+// the position stays inside the file
+void tmpfs_seek(VFSFile* file, uint32_t offset, uint32_t whence)
+{
+    uint32_t size = file->inode->size;
+    switch (whence) {
+    case VFS_BEG:
+        file->position = offset < size ? offset : size;
+        break;
+    case VFS_CUR:
+        file->position = offset < size - file->position ? file->position + offset : size;
+        break;
+    case VFS_END:
+        file->position = offset < size ? size - offset : 0;
+        break;
+    }
+}
+
+uint32_t tmpfs_tell(VFSFile* file)
+{
+    return file->position;
+}
+
+void tmpfs_flush(VFSFile* file)
+{
+    (void)file;
+}
+
+VFSFileOperations get_tmpfs_file_operations()
+{
+    VFSFileOperations fops = {
+        .open = (void*)tmpfs_open,
+        .close = (void*)tmpfs_close,
+        .read = (void*)tmpfs_read,
+        .write = (void*)tmpfs_write,
+        .ioctl = (void*)tmpfs_ioctl,
+        .seek = (void*)tmpfs_seek,
+        .tell = (void*)tmpfs_tell,
+        .flush = (void*)tmpfs_flush,
+        .readv = (void*)tmpfs_readv,
+        .writev = (void*)tmpfs_writev,
+        .submit = NULL,
+        .transfer = (void*)tmpfs_transfer,
+    };
+    return fops;
+}
+
+// name is length bytes long and doesn't have to end with '\0'
+static struct tmpfs_node* find_entry(struct tmpfs_node* directory, const char* name, uint32_t length)
+{
+    for (struct tmpfs_entry* entry = directory->entries; entry != NULL; entry = entry->next) {
+        if (entry->name_length == length && strncmp(entry->name, name, length) == 0) {
+            return entry->node;
+        }
+    }
+    return NULL;
+}
+
+int tmpfs_create_inode(VFSIndexNode* directory, char* name, VFSFileType type)
+{
+    if (directory->type != VFS_DIRECTORY || (type != VFS_REGULAR_FILE && type != VFS_DIRECTORY)) {
+        return 1;
+    }
+    struct tmpfs_node* parent = directory->private_data;
+    uint32_t name_length = strlen(name);
+    struct tmpfs_node* node = (struct tmpfs_node*)malloc(sizeof(struct tmpfs_node));
+    if (node == NULL) {
+        return 1;
+    }
+    struct tmpfs_entry* entry = (struct tmpfs_entry*)malloc(sizeof(struct tmpfs_entry) + name_length + 1);
+    if (entry == NULL) {
+        free(node);
+        return 1;
+    }
+    memset(node, 0, sizeof(struct tmpfs_node));
+    node->number = tmpfs_next_number++;
+    node->type = type;
+
+    entry->node = node;
+    entry->next = NULL;
+    entry->name_length = name_length;
+    memcpy(entry->name, name, name_length + 1);
+    if (parent->last_entry != NULL) {
+        parent->last_entry->next = entry;
+    } else {
+        parent->entries = entry;
+    }
+    parent->last_entry = entry;
+    parent->size++;
+    directory->size = parent->size;
+    return 0;
+}
+
+VFSIndexNode tmpfs_get_inode(char* path)
+{
+    struct tmpfs_node* node = &tmpfs_root;
+    while (*path != '\0') {
+        while (*path == '/') {
+            path++;
+        }
+        uint32_t length = 0;
+        while (path[length] != '\0' && path[length] != '/') {
+            length++;
+        }
+        if (length == 0) {
+            break;
+        }
+        node = node->type == VFS_DIRECTORY ? find_entry(node, path, length) : NULL;
+        if (node == NULL) {
+            return error_inode();
+        }
+        path += length;
+    }
+    return to_vfs(node);
+}
+
+VFSIndexNode tmpfs_lookup(VFSIndexNode* directory, char* name)
+{
+    if (directory->type != VFS_DIRECTORY) {
+        return error_inode();
+    }
+    struct tmpfs_node* node = find_entry(directory->private_data, name, strlen(name));
+    if (node == NULL) {
+        return error_inode();
+    }
+    return to_vfs(node);
+}
+
+VFSDirectory* tmpfs_get_directory(char* path, VFSIndexNode* inode)
+{
+    if (inode->type != VFS_DIRECTORY) {
+        return NULL;
+    }
+    struct tmpfs_node* directory = inode->private_data;
+    VFSDirectory* vfs_dir = (VFSDirectory*)malloc(sizeof(VFSDirectory));
+    if (vfs_dir == NULL) {
+        return NULL;
+    }
+    vfs_dir->inode = inode;
+    vfs_dir->entries_length = 0;
+    vfs_dir->entries = directory->size == 0 ? NULL : (VFSDirectoryEntry*)malloc(sizeof(VFSDirectoryEntry) * directory->size);
+    if (directory->size != 0 && vfs_dir->entries == NULL) {
+        free(vfs_dir);
+        return NULL;
+    }
+
+    uint32_t path_length = strlen(path);
+    uint8_t separator = path[path_length - 1] != '/';
+    for (struct tmpfs_entry* entry = directory->entries; entry != NULL; entry = entry->next) {
+        char* entry_path = (char*)malloc(path_length + separator + entry->name_length + 1);
+        if (entry_path == NULL) {
+            for (uint32_t i = 0; i < vfs_dir->entries_length; i++) {
+                free(vfs_dir->entries[i].path);
+            }
+            free(vfs_dir->entries);
+            free(vfs_dir);
+            return NULL;
+        }
+        memcpy(entry_path, path, path_length);
+        if (separator) {
+            entry_path[path_length] = '/';
+        }
+        memcpy(entry_path + path_length + separator, entry->name, entry->name_length + 1);
+        vfs_dir->entries[vfs_dir->entries_length].path = entry_path;
+        vfs_dir->entries_length++;
+    }
+    return vfs_dir;
+}
+
+// the cookie is the index of the next entry
+uint32_t tmpfs_get_directory_entries(VFSIndexNode* directory, uint32_t* cookie, void* buffer, uint32_t buffer_size)
+{
+    struct tmpfs_entry* entry = ((struct tmpfs_node*)directory->private_data)->entries;
+    for (uint32_t i = 0; i < *cookie && entry != NULL; i++) {
+        entry = entry->next;
+    }
+    uint32_t used = 0;
+    for (; entry != NULL; entry = entry->next) {
+        uint32_t record_length = VFS_DIRECTORY_RECORD_LENGTH(entry->name_length);
+        if (buffer_size - used < record_length) {
+            return used;
+        }
+        VFSDirectoryRecord* record = (VFSDirectoryRecord*)((uint8_t*)buffer + used);
+        record->inode_number = entry->node->number;
+        record->type = entry->node->type;
+        record->size = entry->node->size;
+        record->record_length = record_length;
+        record->name_length = entry->name_length;
+        memcpy(record->name, entry->name, entry->name_length + 1);
+        used += record_length;
+        (*cookie)++;
+    }
+    *cookie = VFS_DIRECTORY_COOKIE_END;
+    return used;
+}
+
+// the inode only points to the node, which stays
+void tmpfs_free_inode_data(VFSIndexNode inode)
+{
+    (void)inode;
+}
+
+VFSDriverOperations get_tmpfs_driver_operations()
+{
+    VFSDriverOperations dops = {
+        .create_inode = tmpfs_create_inode,
+        .get_inode = tmpfs_get_inode,
+        .lookup = tmpfs_lookup,
+        .get_directory = tmpfs_get_directory,
+        .get_directory_entries = tmpfs_get_directory_entries,
+        .free_inode_data = tmpfs_free_inode_data,
+    };
+    return dops;
+}
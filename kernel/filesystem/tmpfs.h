@@ -0,0 +1,16 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+// filesystem that only lives in the kernel heap, mounted with vfs_mount for files that don't have to outlive the boot
+// file data is kept in pages that are allocated the first time they are written, directories are lists of their entries
+// the files stay until reboot, the vfs has no way to remove them
+#define TMPFS_PAGE_SIZE 0x1000
+// the memory budget for file data in pages, writes stop short once it's used up, set with TMPFS_PAGES= in the makefile
+#ifndef TMPFS_PAGES
+#define TMPFS_PAGES 32
+#endif
+
+VFSFileOperations get_tmpfs_file_operations();
+VFSDriverOperations get_tmpfs_driver_operations();
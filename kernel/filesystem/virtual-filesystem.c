@@ -1,7 +1,7 @@
 #include "virtual-filesystem.h"
-#include <hashmap/hashmap.h>
 #include <heap.h>
 #include <memutils.h>
+#include <pager.h>
 #include <print.h>
 
 void* null_function()
@@ -9,25 +9,180 @@ void* null_function()
     return NULL;
 }
 
+static uint32_t null_directory_entries(VFSIndexNode* directory, uint32_t* cookie, void* buffer, uint32_t buffer_size)
+{
+    (void)directory;
+    (void)buffer;
+    (void)buffer_size;
+    *cookie = VFS_DIRECTORY_COOKIE_END;
+    return 0;
+}
+
 VFSDriverOperations dops = {
     .create_inode = (void*)null_function,
     .get_inode = (void*)null_function,
+    .lookup = (void*)null_function,
     .free_inode_data = (void*)null_function,
     .get_directory = (void*)null_function,
+    .get_directory_entries = null_directory_entries,
 };
 
-VFSIndexNode** inodes = NULL;
-uint32_t inodes_size = 0;
-struct hashmap_s hashmap;
+VFSDentry* root_dentry = NULL;
+uint32_t number_of_negative_dentries = 0;
 
-int vfs_init()
+// dentries with an inode nobody holds, the most recently used first
+VFSDentry* first_unused = NULL;
+VFSDentry* last_unused = NULL;
+uint32_t number_of_unused_inodes = 0;
+
+// the driver of the nearest mount point above the dentry, the one set with vfs_set_driver without one
+static VFSDriverOperations* find_driver(VFSDentry* dentry)
 {
-    if (hashmap_create(16, &hashmap) != 0) {
-        return 1;
+    for (; dentry != NULL; dentry = dentry->parent) {
+        if (dentry->mount != NULL) {
+            return dentry->mount;
+        }
+    }
+    return &dops;
+}
+
+// device files have no driver behind them, mount points are virtual too but their driver knows what's below them
+static uint8_t is_device(VFSDentry* dentry)
+{
+    return dentry->is_virtual && dentry->mount == NULL;
+}
+
+static void unlink_dentry(VFSDentry* dentry)
+{
+    VFSDentry** link = &dentry->parent->children;
+    while (*link != dentry) {
+        link = &(*link)->next;
+    }
+    *link = dentry->next;
+}
+
+static void push_unused(VFSDentry* dentry)
+{
+    dentry->unused_previous = NULL;
+    dentry->unused_next = first_unused;
+    if (first_unused != NULL) {
+        first_unused->unused_previous = dentry;
+    } else {
+        last_unused = dentry;
+    }
+    first_unused = dentry;
+    number_of_unused_inodes++;
+}
+
+static void remove_unused(VFSDentry* dentry)
+{
+    if (dentry->unused_previous != NULL) {
+        dentry->unused_previous->unused_next = dentry->unused_next;
+    } else {
+        first_unused = dentry->unused_next;
+    }
+    if (dentry->unused_next != NULL) {
+        dentry->unused_next->unused_previous = dentry->unused_previous;
+    } else {
+        last_unused = dentry->unused_previous;
+    }
+    dentry->unused_previous = NULL;
+    dentry->unused_next = NULL;
+    number_of_unused_inodes--;
+}
+
+// gives the inode back to the driver, the dentry goes too when nothing is below it and so do the parents it leaves empty
+// keep is a dentry the caller still works with, it loses its inode at most
+static void evict_inode(VFSDentry* dentry, VFSDentry* keep)
+{
+    remove_unused(dentry);
+    find_driver(dentry)->free_inode_data(*dentry->inode);
+    free(dentry->inode);
+    dentry->inode = NULL;
+    while (dentry != keep && dentry->parent != NULL && dentry->inode == NULL && dentry->children == NULL) {
+        VFSDentry* parent = dentry->parent;
+        unlink_dentry(dentry);
+        free(dentry);
+        dentry = parent;
+    }
+}
+
+static void trim_unused_inodes(uint32_t max, VFSDentry* keep)
+{
+    while (number_of_unused_inodes > max) {
+        evict_inode(last_unused, keep);
+    }
+}
+
+// memory for the tree, every unused inode is given back when the heap is full
+static void* vfs_alloc(uint32_t size, VFSDentry* keep)
+{
+    void* memory = malloc(size);
+    if (memory == NULL && number_of_unused_inodes != 0) {
+        trim_unused_inodes(0, keep);
+        memory = malloc(size);
     }
-    inodes = (VFSIndexNode**)malloc(sizeof(VFSIndexNode));
-    if (inodes == NULL) {
-        hashmap_destroy(&hashmap);
+    return memory;
+}
+
+// the dentry isn't linked into its parent yet, see link_dentry
+static VFSDentry* new_dentry(VFSDentry* parent, const char* name, uint32_t length)
+{
+    VFSDentry* dentry = (VFSDentry*)vfs_alloc(sizeof(VFSDentry) + length + 1, parent);
+    if (dentry == NULL) {
+        return NULL;
+    }
+    dentry->parent = parent;
+    dentry->children = NULL;
+    dentry->next = NULL;
+    dentry->inode = NULL;
+    dentry->is_virtual = 0;
+    dentry->is_negative = 0;
+    dentry->unused_previous = NULL;
+    dentry->unused_next = NULL;
+    dentry->mount = NULL;
+    memcpy(dentry->name, name, length);
+    dentry->name[length] = '\0';
+    return dentry;
+}
+
+static void link_dentry(VFSDentry* dentry)
+{
+    dentry->next = dentry->parent->children;
+    dentry->parent->children = dentry;
+}
+
+// called when something is added to the directory, the misses in it may not be misses anymore
+static void drop_negative_children(VFSDentry* directory)
+{
+    VFSDentry** link = &directory->children;
+    while (*link != NULL) {
+        VFSDentry* child = *link;
+        if (!child->is_negative) {
+            link = &child->next;
+            continue;
+        }
+        *link = child->next;
+        number_of_negative_dentries--;
+        free(child);
+    }
+}
+
+// returns the cached child called name, which is length bytes long and doesn't have to end with '\0'
+static VFSDentry* find_child(VFSDentry* directory, const char* name, uint32_t length)
+{
+    for (VFSDentry* child = directory->children; child != NULL; child = child->next) {
+        if (strncmp(child->name, name, length) == 0 && child->name[length] == '\0') {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+int vfs_init()
+{
+    root_dentry = new_dentry(NULL, "", 0);
+    if (root_dentry == NULL) {
         return 1;
     }
     return 0;
@@ -39,29 +194,141 @@ void vfs_set_driver(VFSDriverOperations driver_operations)
     return;
 }
 
-VFSIndexNode* insert_new_inode(VFSIndexNode inode, char* path)
+// nobody holds the new inode, so it starts on the unused list unless it's a device file
+VFSIndexNode* insert_new_inode(VFSIndexNode inode, VFSDentry* dentry)
 {
-    void* temp = realloc(inodes, sizeof(VFSIndexNode*) * (inodes_size + 1));
-    if (temp == NULL) {
+    VFSIndexNode* virtual_inode = (VFSIndexNode*)vfs_alloc(sizeof(VFSIndexNode), dentry->parent);
+    if (virtual_inode == NULL) {
+        if (!dentry->is_virtual) {
+            find_driver(dentry)->free_inode_data(inode);
+        }
         return NULL;
     }
-    inodes = (VFSIndexNode**)temp;
-    inodes[inodes_size] = (VFSIndexNode*)malloc(sizeof(VFSIndexNode));
-    *inodes[inodes_size] = inode;
+    *virtual_inode = inode;
+    virtual_inode->dentry = dentry;
+    dentry->inode = virtual_inode;
+    if (!dentry->is_virtual) {
+        push_unused(dentry);
+    }
+    return virtual_inode;
+}
 
-    if (hashmap_put(&hashmap, path, strlen(path), inodes[inodes_size]) != 0) {
-        temp = realloc(inodes, sizeof(VFSIndexNode) * inodes_size);
-        if (temp == NULL) {
+void vfs_hold_inode(VFSIndexNode* inode)
+{
+    if (inode->number_of_references++ == 0 && !inode->dentry->is_virtual) {
+        remove_unused(inode->dentry);
+    }
+}
+
+void vfs_release_inode(VFSIndexNode* inode)
+{
+    if (--inode->number_of_references == 0 && !inode->dentry->is_virtual) {
+        push_unused(inode->dentry);
+        trim_unused_inodes(VFS_MAX_UNUSED_INODES, NULL);
+    }
+}
+
+// asks the driver for the inode of a dentry that doesn't have one yet, returns NULL if the driver doesn't know it
+// a new dentry the driver doesn't know is marked negative, placeholders holding device files stay as they are
+static VFSIndexNode* resolve_inode(VFSDentry* dentry)
+{
+    if (dentry->inode != NULL) {
+        return dentry->inode;
+    }
+    if (dentry->is_negative) {
+        return NULL;
+    }
+    VFSDriverOperations* driver = find_driver(dentry);
+    VFSIndexNode inode;
+    if (dentry->parent == NULL) {
+        inode = driver->get_inode("/");
+    } else {
+        VFSIndexNode* directory = resolve_inode(dentry->parent);
+        if (directory == NULL || directory->type != VFS_DIRECTORY || is_device(dentry->parent)) {
             return NULL;
         }
-        inodes = (VFSIndexNode**)temp;
-        if (inode.type == VFS_REGULAR_FILE) {
-            dops.free_inode_data(inode);
+        inode = driver->lookup(directory, dentry->name);
+    }
+    if (inode.type == VFS_ERROR) {
+        driver->free_inode_data(inode);
+        if (dentry->parent != NULL && dentry->children == NULL) {
+            dentry->is_negative = 1;
+            number_of_negative_dentries++;
         }
         return NULL;
     }
-    inodes_size++;
-    return inodes[inodes_size - 1];
+    return insert_new_inode(inode, dentry);
+}
+
+// walks the components of the path up to end, the ones that aren't cached are looked up in their directory
+// with make_placeholders missing components are added without asking the driver, for device files made before it's set
+// returns NULL if a component doesn't exist, the miss is cached while there's room
+static VFSDentry* walk_path(const char* path, const char* end, uint8_t make_placeholders)
+{
+    if (path[0] != '/') {
+        return NULL;
+    }
+    VFSDentry* dentry = root_dentry;
+    const char* component = path;
+    while (1) {
+        while (component < end && *component == '/') {
+            component++;
+        }
+        if (component >= end) {
+            return dentry;
+        }
+        uint32_t length = 0;
+        while (component + length < end && component[length] != '/') {
+            length++;
+        }
+        VFSDentry* child = find_child(dentry, component, length);
+        if (child != NULL && child->is_negative) {
+            if (!make_placeholders) {
+                return NULL;
+            }
+            child->is_negative = 0;
+            number_of_negative_dentries--;
+        } else if (child == NULL) {
+            child = new_dentry(dentry, component, length);
+            if (child == NULL) {
+                return NULL;
+            }
+            // linked first so evicting inodes while it's resolved can't free the directory
+            link_dentry(child);
+            if (!make_placeholders && resolve_inode(child) == NULL) {
+                if (!child->is_negative || number_of_negative_dentries > VFS_MAX_NEGATIVE_DENTRIES) {
+                    number_of_negative_dentries -= child->is_negative;
+                    unlink_dentry(child);
+                    free(child);
+                }
+                return NULL;
+            }
+        }
+        dentry = child;
+        component += length;
+    }
+}
+
+// returns NULL if the file doesn't exist
+static VFSIndexNode* lookup_inode(char* path)
+{
+    VFSDentry* dentry = walk_path(path, path + strlen(path), 0);
+    if (dentry == NULL) {
+        return NULL;
+    }
+    return resolve_inode(dentry);
+}
+
+// returns the name of the file, which starts after the last '/'
+static char* find_name(char* path)
+{
+    char* name = path;
+    for (char* c = path; *c != '\0'; c++) {
+        if (*c == '/') {
+            name = c + 1;
+        }
+    }
+    return name;
 }
 
 void free_directory(VFSDirectory* dir)
@@ -79,6 +346,20 @@ void free_directory(VFSDirectory* dir)
     return;
 }
 
+// returns the directory the file at path goes in, NULL if it doesn't exist
+static VFSDentry* find_directory(char* path)
+{
+    VFSDentry* directory = walk_path(path, find_name(path), 0);
+    if (directory == NULL || is_device(directory)) {
+        return NULL;
+    }
+    VFSIndexNode* inode = resolve_inode(directory);
+    if (inode == NULL || inode->type != VFS_DIRECTORY) {
+        return NULL;
+    }
+    return directory;
+}
+
 // returns 0 on success
 int vfs_create_regular_file(char* path)
 {
@@ -89,24 +370,20 @@ int vfs_create_regular_file(char* path)
         return 1; // directory
     }
 
-    if (hashmap_get(&hashmap, path, strlen(path)) != NULL) {
-        return 1; // already exists in virtual filesystem
+    if (lookup_inode(path) != NULL) {
+        return 1; // already exists
     };
 
-    uint32_t offset = 0;
-    for (int i = strlen(path); i >= 0; i--) {
-        if (path[i] == '/') {
-            path[i] = '\0';
-            offset = i;
-            break;
-        }
+    VFSDentry* directory = find_directory(path);
+    if (directory == NULL) {
+        return 1; // directory does not exist
     }
-    char* name = path + offset + 1;
-
-    int ret = dops.create_inode(path, name, VFS_REGULAR_FILE); // will check if it already exists
-
-    path[offset] = '/';
 
+    int ret = find_driver(directory)->create_inode(directory->inode, find_name(path), VFS_REGULAR_FILE);
+    if (ret == 0) {
+        drop_negative_children(directory);
+    }
+    trim_unused_inodes(VFS_MAX_UNUSED_INODES, NULL);
     return ret;
 }
 
@@ -119,40 +396,37 @@ int vfs_create_device_file(char* path, VFSFileOperations fops, VFSFileType type)
         return 1; // directory
     }
 
-    if (hashmap_get(&hashmap, path, strlen(path)) != NULL) {
-        return 1; // already exists
-    }
-
-    VFSIndexNode physical_inode = dops.get_inode(path);
-    if (physical_inode.type != VFS_ERROR) {
-        dops.free_inode_data(physical_inode);
+    if (lookup_inode(path) != NULL) {
         return 1; // file already exists
     }
-    dops.free_inode_data(physical_inode);
-
-    uint32_t offset = 0;
-    for (int i = strlen(path); i >= 0; i--) {
-        if (path[i] == '/') {
-            path[i] = '\0';
-            offset = i;
-            break;
-        }
-    }
 
-    VFSIndexNode dir_physical_inode = dops.get_inode(path);
-    if (dir_physical_inode.type != VFS_DIRECTORY) {
-        dops.free_inode_data(dir_physical_inode);
-        path[offset] = '/';
+    if (find_directory(path) == NULL) {
         return 1; // directory does not exist
     }
-    dops.free_inode_data(dir_physical_inode);
-    path[offset] = '/';
 
-    return vfs_create_device_file_no_checks(path, fops, type);
+    int ret = vfs_create_device_file_no_checks(path, fops, type);
+    trim_unused_inodes(VFS_MAX_UNUSED_INODES, NULL);
+    return ret;
 }
 
 int vfs_create_device_file_no_checks(char* path, VFSFileOperations fops, VFSFileType type)
 {
+    char* name = find_name(path);
+    VFSDentry* directory = walk_path(path, name, 1);
+    if (directory == NULL || *name == '\0') {
+        return 1;
+    }
+    VFSDentry* dentry = find_child(directory, name, strlen(name));
+    if (dentry != NULL && !dentry->is_negative) {
+        return 1;
+    }
+    drop_negative_children(directory);
+    dentry = new_dentry(directory, name, strlen(name));
+    if (dentry == NULL) {
+        return 1;
+    }
+    dentry->is_virtual = 1;
+
     VFSIndexNode inode = {
         .type = type,
         .size = 0,
@@ -160,127 +434,209 @@ int vfs_create_device_file_no_checks(char* path, VFSFileOperations fops, VFSFile
         .private_data = NULL,
         .number_of_references = 0,
     };
-    if (insert_new_inode(inode, path) == NULL) {
+    if (insert_new_inode(inode, dentry) == NULL) {
+        free(dentry);
         return 1;
     }
+    link_dentry(dentry);
     return 0;
 }
 
 int vfs_create_directory(char* path);
 
-struct hash_dir_iter_t {
-    char* path;
-    VFSDirectory* dir;
-};
-
-int hash_dir_iter(void* const context, struct hashmap_element_s* const e)
+int vfs_mount(char* path, VFSDriverOperations driver_operations)
 {
-    struct hash_dir_iter_t* iter = (struct hash_dir_iter_t*)context;
-    char* path = iter->path;
-    VFSDirectory* dir = iter->dir;
-
-    if (strncmp((char*)e->key, path, strlen(path)) == 0) {
-
-        char* rest = ((char*)e->key) + strlen(path);
-
-        if (*rest == '\0') {
-            return 0;
-        }
-
-        if (strchr(rest, '/') != NULL) {
-            return 0;
-        }
-
-        if (rest[-1] != '/') {
-            return 0;
-        }
-
-        for (uint32_t i = 0; i < dir->entries_length; i++) {
-            if (strcmp((char*)e->key, dir->entries[i].path) == 0) {
-                return 0;
-            }
-        }
-
-        void* temp = realloc(dir->entries, sizeof(VFSDirectoryEntry) * (dir->entries_length + 1));
-        if (temp == NULL) {
-            return 1;
+    VFSDentry* dentry = walk_path(path, path + strlen(path), 1);
+    if (dentry == NULL || dentry->parent == NULL || dentry->is_virtual || dentry->children != NULL) {
+        return 1;
+    }
+    if (dentry->inode != NULL) {
+        if (dentry->inode->number_of_references != 0) {
+            return 1; // the file of the old driver is open
         }
-        dir->entries = (VFSDirectoryEntry*)temp;
+        evict_inode(dentry, dentry);
+    }
+    VFSDriverOperations* driver = (VFSDriverOperations*)vfs_alloc(sizeof(VFSDriverOperations), dentry);
+    if (driver == NULL) {
+        return 1;
+    }
+    *driver = driver_operations;
 
-        char* copied_path = (char*)malloc(e->key_len + 1);
-        if (copied_path == NULL) {
-            free_directory(dir);
-            return 1;
-        }
+    VFSIndexNode inode = driver->get_inode("/");
+    if (inode.type != VFS_DIRECTORY) {
+        driver->free_inode_data(inode);
+        free(driver);
+        return 1;
+    }
+    // virtual so the root of the driver is never evicted and the parent lists it with its device files
+    dentry->is_virtual = 1;
+    dentry->mount = driver;
+    if (insert_new_inode(inode, dentry) == NULL) {
+        driver->free_inode_data(inode);
+        dentry->is_virtual = 0;
+        dentry->mount = NULL;
+        free(driver);
+        return 1;
+    }
+    return 0;
+}
 
-        strncpy(copied_path, e->key, e->key_len);
-        copied_path[e->key_len] = '\0';
+// the path of the entry is path/name, returns 1 if there's no memory left
+static int add_directory_entry(VFSDirectory* dir, char* path, char* name)
+{
+    uint32_t path_length = strlen(path);
+    uint32_t name_length = strlen(name);
+    uint8_t separator = path[path_length - 1] != '/';
+    VFSDirectoryEntry* entries = dir->entries == NULL
+        ? (VFSDirectoryEntry*)malloc(sizeof(VFSDirectoryEntry))
+        : (VFSDirectoryEntry*)realloc(dir->entries, sizeof(VFSDirectoryEntry) * (dir->entries_length + 1));
+    if (entries == NULL) {
+        return 1;
+    }
+    dir->entries = entries;
 
-        dir->entries[dir->entries_length].path = copied_path;
-        dir->entries_length++;
+    char* entry_path = (char*)malloc(path_length + separator + name_length + 1);
+    if (entry_path == NULL) {
+        return 1;
     }
+    memcpy(entry_path, path, path_length);
+    if (separator) {
+        entry_path[path_length] = '/';
+    }
+    memcpy(entry_path + path_length + separator, name, name_length + 1);
 
+    dir->entries[dir->entries_length].path = entry_path;
+    dir->entries_length++;
     return 0;
 }
 
 VFSDirectory* vfs_open_directory(char* path)
 {
-    VFSIndexNode* virtual_inode = hashmap_get(&hashmap, path, strlen(path));
-
-    if (virtual_inode == NULL) {
-        VFSIndexNode physical_inode = dops.get_inode(path);
-        if (physical_inode.type == VFS_ERROR) {
-            dops.free_inode_data(physical_inode);
-            return NULL;
-        }
-        virtual_inode = insert_new_inode(physical_inode, path);
+    VFSDentry* dentry = walk_path(path, path + strlen(path), 0);
+    if (dentry == NULL || is_device(dentry) || resolve_inode(dentry) == NULL) {
+        return NULL;
     }
 
-    VFSDirectory* dir = dops.get_directory(path, virtual_inode);
+    VFSDirectory* dir = find_driver(dentry)->get_directory(path, dentry->inode);
     if (dir == NULL) {
         return NULL;
     }
-    dir->inode->number_of_references++;
-    struct hash_dir_iter_t iter_value = {
-        .path = path,
-        .dir = dir,
-    };
-    hashmap_iterate_pairs(&hashmap, hash_dir_iter, &iter_value);
-    if (dir == NULL) {
-        return NULL;
+    vfs_hold_inode(dir->inode);
+    // the driver doesn't know about the device files in the directory
+    for (VFSDentry* child = dentry->children; child != NULL; child = child->next) {
+        if (child->is_virtual && add_directory_entry(dir, path, child->name) != 0) {
+            vfs_close_directory(dir);
+            return NULL;
+        }
     }
+    trim_unused_inodes(VFS_MAX_UNUSED_INODES, NULL);
     return dir;
 }
 
+// the device files of the directory in the order of its children, the cookie counts the ones already written
+static uint32_t get_device_entries(VFSDentry* directory, uint32_t* cookie, void* buffer, uint32_t buffer_size)
+{
+    uint32_t used = 0;
+    uint32_t index = 0;
+    for (VFSDentry* child = directory->children; child != NULL; child = child->next) {
+        if (!child->is_virtual || index++ < (*cookie & ~VFS_DIRECTORY_COOKIE_DEVICES)) {
+            continue;
+        }
+        uint32_t name_length = strlen(child->name);
+        uint32_t record_length = VFS_DIRECTORY_RECORD_LENGTH(name_length);
+        if (buffer_size - used < record_length) {
+            return used;
+        }
+        VFSDirectoryRecord* record = (VFSDirectoryRecord*)((uint8_t*)buffer + used);
+        record->inode_number = 0;
+        // the directories made for device files before the driver was set have no inode
+        record->type = child->inode != NULL ? child->inode->type : VFS_DIRECTORY;
+        record->size = child->inode != NULL ? child->inode->size : 0;
+        record->record_length = record_length;
+        record->name_length = name_length;
+        memcpy(record->name, child->name, name_length + 1);
+        used += record_length;
+        (*cookie)++;
+    }
+    *cookie = VFS_DIRECTORY_COOKIE_END;
+    return used;
+}
+
+uint32_t vfs_get_directory_entries(char* path, uint32_t* cookie, void* buffer, uint32_t buffer_size)
+{
+    VFSDentry* dentry = walk_path(path, path + strlen(path), 0);
+    uint32_t used = 0;
+    if (dentry != NULL && !is_device(dentry) && resolve_inode(dentry) != NULL && dentry->inode->type == VFS_DIRECTORY && *cookie != VFS_DIRECTORY_COOKIE_END) {
+        if (!(*cookie & VFS_DIRECTORY_COOKIE_DEVICES)) {
+            used = find_driver(dentry)->get_directory_entries(dentry->inode, cookie, buffer, buffer_size);
+            if (*cookie == VFS_DIRECTORY_COOKIE_END) {
+                *cookie = VFS_DIRECTORY_COOKIE_DEVICES;
+            }
+        }
+        if (*cookie & VFS_DIRECTORY_COOKIE_DEVICES) {
+            used += get_device_entries(dentry, cookie, (uint8_t*)buffer + used, buffer_size - used);
+        }
+    }
+    trim_unused_inodes(VFS_MAX_UNUSED_INODES, NULL);
+    return used;
+}
+
 void vfs_close_directory(VFSDirectory* vfs_directory)
 {
-    vfs_directory->inode->number_of_references--;
+    VFSIndexNode* inode = vfs_directory->inode;
     free_directory(vfs_directory);
+    vfs_release_inode(inode);
+}
+
+// copies the metadata vfs_stat and vfs_fstat return out of the cached inode
+static void fill_stat(VFSIndexNode* inode, VFSStat* stat)
+{
+    stat->type = inode->type;
+    stat->size = inode->size;
+    stat->version = inode->version;
+    stat->flags = inode->dentry != NULL && is_device(inode->dentry) ? VFS_STAT_DEVICE : 0;
+}
+
+int vfs_stat(char* path, VFSStat* stat)
+{
+    VFSIndexNode* inode = lookup_inode(path);
+    if (inode != NULL) {
+        fill_stat(inode, stat);
+    }
+    trim_unused_inodes(VFS_MAX_UNUSED_INODES, NULL);
+    return inode == NULL;
+}
+
+void vfs_fstat(VFSFile* file, VFSStat* stat)
+{
+    fill_stat(file->inode, stat);
 }
 
 // returns NULL on fail
 VFSFile* vfs_open_file(char* path, VFSFileFlags flags)
 {
-    VFSIndexNode* virtual_inode = hashmap_get(&hashmap, path, strlen(path));
-
+    VFSIndexNode* virtual_inode = lookup_inode(path);
     if (virtual_inode == NULL) {
-        VFSIndexNode physical_inode = dops.get_inode(path);
-        if (physical_inode.type == VFS_ERROR) {
-            dops.free_inode_data(physical_inode);
-            return NULL;
-        }
-        virtual_inode = insert_new_inode(physical_inode, path);
+        return NULL;
     }
 
     VFSFile* file = virtual_inode->file_operations.open(virtual_inode, flags);
-    virtual_inode->number_of_references++;
+    if (file != NULL) {
+        vfs_hold_inode(virtual_inode);
+    }
+    trim_unused_inodes(VFS_MAX_UNUSED_INODES, NULL);
     return file;
 }
 
 void vfs_close_file(VFSFile* file)
 {
-    file->inode->number_of_references--;
-    file->inode->file_operations.close(file);
+    VFSIndexNode* inode = file->inode;
+    // inodes without a dentry belong to the driver and can be gone after close
+    uint8_t anonymous = inode->dentry == NULL;
+    inode->file_operations.close(file);
+    if (!anonymous) {
+        vfs_release_inode(inode);
+    }
 }
 
 uint32_t vfs_read(VFSFile* file, void* buffer, uint32_t buffer_size)
@@ -290,8 +646,40 @@ uint32_t vfs_read(VFSFile* file, void* buffer, uint32_t buffer_size)
 
 uint32_t vfs_write(VFSFile* file, void* buffer, uint32_t buffer_size)
 {
+    file->inode->version++;
     return file->inode->file_operations.write(file, buffer, buffer_size);
 }
+uint32_t vfs_readv(VFSFile* file, VFSIOVector* vectors, uint32_t count)
+{
+    if (file->inode->file_operations.readv != NULL) {
+        return file->inode->file_operations.readv(file, vectors, count);
+    }
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t length = file->inode->file_operations.read(file, vectors[i].buffer, vectors[i].length);
+        total += length;
+        if (length < vectors[i].length) {
+            break;
+        }
+    }
+    return total;
+}
+uint32_t vfs_writev(VFSFile* file, VFSIOVector* vectors, uint32_t count)
+{
+    file->inode->version++;
+    if (file->inode->file_operations.writev != NULL) {
+        return file->inode->file_operations.writev(file, vectors, count);
+    }
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t length = file->inode->file_operations.write(file, vectors[i].buffer, vectors[i].length);
+        total += length;
+        if (length < vectors[i].length) {
+            break;
+        }
+    }
+    return total;
+}
 
 void vfs_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg)
 {
@@ -312,3 +700,56 @@ void vfs_flush(VFSFile* file)
 {
     file->inode->file_operations.flush(file);
 }
+
+uint32_t vfs_transfer(VFSFile* out, VFSFile* in, uint32_t length)
+{
+    if (in->inode->file_operations.transfer != NULL) {
+        return in->inode->file_operations.transfer(in, out, length);
+    }
+
+    uint8_t* buffer = malloc(VFS_TRANSFER_BUFFER_SIZE);
+    if (buffer == NULL) {
+        return 0;
+    }
+    uint32_t moved = 0;
+    while (moved < length) {
+        uint32_t part = length - moved < VFS_TRANSFER_BUFFER_SIZE ? length - moved : VFS_TRANSFER_BUFFER_SIZE;
+        uint32_t read = vfs_read(in, buffer, part);
+        uint32_t written = read == 0 ? 0 : vfs_write(out, buffer, read);
+        moved += written;
+        if (read < part || written < read) {
+            break;
+        }
+    }
+    free(buffer);
+    return moved;
+}
+
+void vfs_submit(VFSRequest* request)
+{
+    request->done = 0;
+    request->result = 0;
+    request->page_table = get_loaded_page_table();
+    request->next = NULL;
+    if (request->write) {
+        // counted when it's submitted so caches of the contents don't trust the old data meanwhile
+        request->file->inode->version++;
+    }
+
+    VFSFileOperations* fops = &request->file->inode->file_operations;
+    if (fops->submit != NULL && fops->submit(request->file, request) == 0) {
+        return;
+    }
+    uint32_t result = request->write ? fops->write(request->file, request->buffer, request->length)
+                                     : fops->read(request->file, request->buffer, request->length);
+    vfs_complete_request(request, result);
+}
+
+void vfs_complete_request(VFSRequest* request, uint32_t result)
+{
+    request->result = result;
+    request->done = 1;
+    if (request->complete != NULL) {
+        request->complete(request);
+    }
+}
@@ -15,6 +15,7 @@ typedef enum {
     VFS_DIRECTORY = 2,
     VFS_BLOCK_DEVICE = 2,
     VFS_CHARACTER_DEVICE = 3,
+    VFS_PIPE = 4, // an end of a pipe, see pipe.h
 } VFSFileType;
 
 typedef enum {
@@ -23,6 +24,12 @@ typedef enum {
     VFS_APPEND = 0b001,
 } VFSFileFlags;
 
+// one buffer of a scatter/gather read or write
+typedef struct {
+    void* buffer;
+    uint32_t length;
+} VFSIOVector;
+
 typedef struct {
     void* (*open)(void* inode, VFSFileFlags flags); // returns VFSFile
     void (*close)(void* file);
@@ -32,6 +39,15 @@ typedef struct {
     void (*seek)(void* file, uint32_t offset, VFSWhence whence);
     uint32_t (*tell)(void* file);
     void (*flush)(void* file);
+    // optional, move every vector in one call, returns the total number of bytes. the vfs loops over read/write when NULL
+    uint32_t (*readv)(void* file, VFSIOVector* vectors, uint32_t count);
+    uint32_t (*writev)(void* file, VFSIOVector* vectors, uint32_t count);
+    // optional, start a VFSRequest and return 0, the driver finishes it later with vfs_complete_request
+    // the vfs runs the request with read/write right away when NULL or when it returns 1
+    uint8_t (*submit)(void* file, void* request);
+    // optional, write up to length bytes from the position of file straight into the VFSFile out, returns the number of bytes moved
+    // vfs_transfer copies through a buffer when NULL
+    uint32_t (*transfer)(void* file, void* out, uint32_t length);
 } VFSFileOperations;
 
 typedef struct {
@@ -40,6 +56,8 @@ typedef struct {
     VFSFileOperations file_operations;
     void* private_data;
     uint32_t number_of_references;
+    uint32_t version; // changes with every write, lets caches of the contents notice
+    struct VFSDentry* dentry; // set by the vfs, NULL for inodes made outside of it like the ones of pipes
 } VFSIndexNode;
 
 typedef struct {
@@ -49,6 +67,48 @@ typedef struct {
     uint32_t position;
 } VFSFile;
 
+// a read or write that finishes after vfs_submit returns, it moves length bytes at the position of the file like vfs_read/vfs_write
+// the file and the buffer have to stay valid until done is set
+typedef struct VFSRequest {
+    VFSFile* file;
+    void* buffer;
+    uint32_t length;
+    uint8_t write;
+    volatile uint8_t done;
+    uint32_t result; // bytes read/written, valid once done is set
+    void* page_table; // PDETable the buffer is mapped in, set by vfs_submit
+    void (*complete)(struct VFSRequest* request); // optional, called with kernel_lock held right after done is set
+    void* private_data; // for whoever submitted the request
+    struct VFSRequest* next; // for the driver while the request is queued
+    uint8_t queue_flags; // same
+} VFSRequest;
+
+// a cached path component, every directory keeps the children that were looked up so far
+// paths are resolved one component at a time from the root and the driver is only asked for the missing ones
+typedef struct VFSDentry {
+    struct VFSDentry* parent;
+    struct VFSDentry* children;
+    struct VFSDentry* next; // in parent->children
+    VFSIndexNode* inode; // NULL until it's needed, the directories of device files made before the driver is set start like this
+    uint8_t is_virtual; // device files and mount points only exist in the vfs, the driver doesn't list them
+    uint8_t is_negative; // the driver has no such file, dropped when something is created in the directory
+    // on the unused list while nobody holds the inode, see VFS_MAX_UNUSED_INODES
+    struct VFSDentry* unused_previous;
+    struct VFSDentry* unused_next;
+    struct VFSDriverOperations* mount; // the driver of everything below a mount point, NULL takes the one of the parent
+    char name[];
+} VFSDentry;
+
+// size of the buffer vfs_transfer copies through when the source can't give its data in place
+#define VFS_TRANSFER_BUFFER_SIZE 0x1000
+// misses are remembered so looking up the same missing file again doesn't read the disk
+#define VFS_MAX_NEGATIVE_DENTRIES 64
+// inodes without references stay cached until there are more than this many, the least recently used go first
+// all of them are given back when the heap is full, set with VFS_MAX_UNUSED_INODES= in the makefile
+#ifndef VFS_MAX_UNUSED_INODES
+#define VFS_MAX_UNUSED_INODES 128
+#endif
+
 typedef struct {
     char* path;
 } VFSDirectoryEntry;
@@ -59,33 +119,73 @@ typedef struct {
     uint32_t entries_length;
 } VFSDirectory;
 
+// metadata of a file copied out of its cached inode by vfs_stat and vfs_fstat
 typedef struct {
-    int (*create_inode)(char* path, char* name, VFSFileType type);
+    uint32_t type; // VFSFileType
+    uint32_t size;
+    uint32_t version; // changes with every write
+    uint32_t flags;
+} VFSStat;
+
+enum {
+    VFS_STAT_DEVICE = 1, // the file only exists in the vfs
+};
+
+// one entry written by vfs_get_directory_entries, the records are packed one after the other
+typedef struct {
+    uint32_t inode_number; // number the driver knows the file by, 0 for device files
+    uint32_t size;
+    uint16_t record_length; // bytes to the next record, a multiple of 4
+    uint16_t name_length; // without the null terminator
+    uint8_t type; // VFSFileType
+    char name[]; // null terminated
+} VFSDirectoryRecord;
+
+#define VFS_DIRECTORY_RECORD_LENGTH(name_length) ((sizeof(VFSDirectoryRecord) + (name_length) + 1 + 3) & ~3u)
+// a cookie of 0 starts at the first entry, the device files of the directory come after the ones of the driver
+#define VFS_DIRECTORY_COOKIE_DEVICES 0x80000000
+#define VFS_DIRECTORY_COOKIE_END 0xFFFFFFFF
+
+typedef struct VFSDriverOperations {
+    int (*create_inode)(VFSIndexNode* directory, char* name, VFSFileType type);
     VFSIndexNode (*get_inode)(char* path);
+    VFSIndexNode (*lookup)(VFSIndexNode* directory, char* name);
     VFSDirectory* (*get_directory)(char* path, VFSIndexNode* inode);
     void (*free_inode_data)(VFSIndexNode inode);
+    uint32_t (*get_directory_entries)(VFSIndexNode* directory, uint32_t* cookie, void* buffer, uint32_t buffer_size);
 } VFSDriverOperations;
 
 /*
  *
  *  All driver functions should NOT modify the VFSIndexNode.number_of_refrences variable.
  *  The driver should set number_of_refrences to 0 when it makes one in get_inode
- *  Open and close will keep track of refrences to each index node.
- *  The VFS will auto remove inodes no longer in use.
+ *  Open and close will keep track of refrences to each index node, vfs_hold_inode and vfs_release_inode keep one without a file.
+ *  The VFS will auto remove inodes no longer in use, device files are kept.
  *  The VFS expects that a file will be safe to remove after calling file_operations.flush().
  *  The VFS expects that an inode will be safe to remove after calling free_inode_data.
  *  The filesystem drivers are expected to set the file operations when get_inode is called.
  *
- *  create_inode should return 0 on success
- *  get_inode should return an index node with a type of VFS_ERROR on fail
+ *  create_inode should return 0 on success, the VFS checks that the name isn't used in the directory yet
+ *  and the driver has to keep the directory inode it was given up to date
+ *  get_inode should return an index node with a type of VFS_ERROR on fail, the VFS only uses it for the root "/"
+ *  lookup should return the inode of the entry called name in directory, or one with a type of VFS_ERROR if there is none
  *  free_inode_data should free just the private data of the inode that the driver allocated
  *  get_directory should return NULL on fail
+ *  get_directory_entries should fill buffer with the VFSDirectoryRecords that fit, starting at the entry the cookie points to
+ *  and return the number of bytes used, the cookie is moved past the written entries and set to VFS_DIRECTORY_COOKIE_END after the last one
+ *  the driver picks its cookies below VFS_DIRECTORY_COOKIE_DEVICES
+ *
+ *  A driver mounted with vfs_mount gets paths and inodes below its mount point only, get_inode is asked for its "/"
+ *  and the paths given to get_directory still start at the root of the vfs.
  *
  */
 
 int vfs_init();
 
 void vfs_set_driver(VFSDriverOperations driver_operations);
+// everything below path is handled by driver from then on, whatever the driver of the parent has there is hidden
+// the directories on the way are made like the ones of device files, returns 0 on success and 1 if path is already used
+int vfs_mount(char* path, VFSDriverOperations driver_operations);
 
 // returns 0 on success
 int vfs_create_regular_file(char* path);
@@ -93,15 +193,36 @@ int vfs_create_device_file(char* path, VFSFileOperations fops, VFSFileType type)
 int vfs_create_device_file_no_checks(char* path, VFSFileOperations fops, VFSFileType type);
 int vfs_create_directory(char* path);
 
+// keeps the inode in memory while the caller points to it without an open file
+void vfs_hold_inode(VFSIndexNode* inode);
+void vfs_release_inode(VFSIndexNode* inode);
+
 VFSDirectory* vfs_open_directory(char* path);
 void vfs_close_directory(VFSDirectory* vfs_directory);
+// fills buffer with the records of the entries after cookie without building a VFSDirectory, returns the number of bytes used
+// returns 0 once the cookie reached the end, if the next record doesn't fit or if path isn't a directory
+uint32_t vfs_get_directory_entries(char* path, uint32_t* cookie, void* buffer, uint32_t buffer_size);
+
+// the driver is only asked when the inode isn't cached, returns 0 on success
+int vfs_stat(char* path, VFSStat* stat);
+void vfs_fstat(VFSFile* file, VFSStat* stat);
 
 // returns NULL on fail
 VFSFile* vfs_open_file(char* path, VFSFileFlags flags);
 void vfs_close_file(VFSFile* file);
 uint32_t vfs_read(VFSFile* file, void* buffer, uint32_t buffer_size);
 uint32_t vfs_write(VFSFile* file, void* buffer, uint32_t buffer_size);
+// stop at the first vector that isn't filled or written completely
+uint32_t vfs_readv(VFSFile* file, VFSIOVector* vectors, uint32_t count);
+uint32_t vfs_writev(VFSFile* file, VFSIOVector* vectors, uint32_t count);
 void vfs_ioctl(VFSFile* file, uint32_t *command, uint32_t *arg);
 void vfs_seek(VFSFile* file, uint32_t offset, uint32_t whence);
 uint32_t vfs_tell(VFSFile* file);
 void vfs_flush(VFSFile* file);
+// moves up to length bytes from the position of in to out without going through the caller, returns the number of bytes written
+// stops at the end of in or at the first short write, in can be ahead of what was written then
+uint32_t vfs_transfer(VFSFile* out, VFSFile* in, uint32_t length);
+// hands the request to the driver, it is already done when this returns unless the driver queued it
+void vfs_submit(VFSRequest* request);
+// called by the driver that queued the request
+void vfs_complete_request(VFSRequest* request, uint32_t result);
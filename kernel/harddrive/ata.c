@@ -62,3 +62,37 @@ void ata_write_sector(uint32_t lba, uint8_t* buffer)
     outb(ATA_CMD, 0xE7);
     ata_wait();
 }
+
+void ata_read_sectors(uint32_t lba, uint32_t count, uint8_t* buffer)
+{
+    outb(ATA_DRIVE, 0xE0 | ((lba >> 24) & 0x0F));
+    outb(ATA_SECCOUNT, (uint8_t)count); // 0 means 256
+    outb(ATA_LBA_LOW, (uint8_t)(lba));
+    outb(ATA_LBA_MID, (uint8_t)(lba >> 8));
+    outb(ATA_LBA_HIGH, (uint8_t)(lba >> 16));
+    outb(ATA_CMD, 0x20);
+
+    for (uint32_t i = 0; i < count; i++) {
+        ata_wait();
+        insw(ATA_DATA, buffer + i * 512, 256);
+    }
+}
+
+void ata_write_sectors(uint32_t lba, uint32_t count, uint8_t* buffer)
+{
+    outb(ATA_DRIVE, 0xE0 | ((lba >> 24) & 0x0F));
+    outb(ATA_SECCOUNT, (uint8_t)count);
+    outb(ATA_LBA_LOW, (uint8_t)(lba));
+    outb(ATA_LBA_MID, (uint8_t)(lba >> 8));
+    outb(ATA_LBA_HIGH, (uint8_t)(lba >> 16));
+    outb(ATA_CMD, 0x30);
+
+    for (uint32_t i = 0; i < count; i++) {
+        ata_wait();
+        outsw(ATA_DATA, buffer + i * 512, 256);
+    }
+
+    // one cache flush for the whole run
+    outb(ATA_CMD, 0xE7);
+    ata_wait();
+}
@@ -14,5 +14,10 @@
 #define ATA_STATUS     0x1F7
 #define ATA_CONTROL    0x3F6
 
+#define ATA_MAX_SECTORS 256
+
 void ata_read_sector(uint32_t lba, uint8_t* buffer);
 void ata_write_sector(uint32_t lba, uint8_t* buffer);
+// one command for up to ATA_MAX_SECTORS consecutive sectors
+void ata_read_sectors(uint32_t lba, uint32_t count, uint8_t* buffer);
+void ata_write_sectors(uint32_t lba, uint32_t count, uint8_t* buffer);
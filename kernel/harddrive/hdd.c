@@ -1,10 +1,15 @@
 #include "hdd.h"
 #include "ata.h"
 #include "filesystem/virtual-filesystem.h"
+#include <filesystem/io-queue.h>
 #include <heap.h>
 #include <print.h>
+#include <spinlock.h>
 #include <stdint.h>
 
+// the drive takes one command at a time, every transfer holds the lock with interrupts off
+spinlock_t hdd_lock = SPINLOCK_INIT;
+
 VFSFile* hdd_open(VFSIndexNode* inode, VFSFileFlags flags)
 {
     VFSFile* file = (VFSFile*)malloc(sizeof(VFSFile));
@@ -20,24 +25,67 @@ void hdd_close(VFSFile* file)
     free(file);
 }
 
-uint32_t hdd_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+// the vectors cover consecutive sectors from the current position, which is left unchanged like a single read
+// only whole sectors of each vector are transferred
+uint32_t hdd_readv(VFSFile* file, VFSIOVector* vectors, uint32_t count)
 {
-    uint32_t n_sectors = buffer_size / SECTOR_SIZE;
-    uint32_t i;
-    for (i = 0; i < n_sectors; i++) {
-        ata_read_sector(file->position + i, buffer + i * SECTOR_SIZE);
+    uint32_t lba = file->position;
+    uint32_t total = 0;
+    uint32_t eflags = spin_lock_irqsave(&hdd_lock);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t n_sectors = vectors[i].length / SECTOR_SIZE;
+        uint8_t* buffer = vectors[i].buffer;
+        while (n_sectors > 0) {
+            uint32_t run = n_sectors < ATA_MAX_SECTORS ? n_sectors : ATA_MAX_SECTORS;
+            ata_read_sectors(lba, run, buffer);
+            lba += run;
+            buffer += run * SECTOR_SIZE;
+            total += run * SECTOR_SIZE;
+            n_sectors -= run;
+        }
     }
-    return i * 512;
+    spin_unlock_irqrestore(&hdd_lock, eflags);
+    return total;
 }
 
-uint32_t hdd_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+uint32_t hdd_writev(VFSFile* file, VFSIOVector* vectors, uint32_t count)
 {
-    uint32_t n_sectors = buffer_size / SECTOR_SIZE;
-    uint32_t i;
-    for (i = 0; i < n_sectors; i++) {
-        ata_write_sector(file->position + i, buffer + i * SECTOR_SIZE);
+    uint32_t lba = file->position;
+    uint32_t total = 0;
+    uint32_t eflags = spin_lock_irqsave(&hdd_lock);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t n_sectors = vectors[i].length / SECTOR_SIZE;
+        uint8_t* buffer = vectors[i].buffer;
+        while (n_sectors > 0) {
+            uint32_t run = n_sectors < ATA_MAX_SECTORS ? n_sectors : ATA_MAX_SECTORS;
+            ata_write_sectors(lba, run, buffer);
+            lba += run;
+            buffer += run * SECTOR_SIZE;
+            total += run * SECTOR_SIZE;
+            n_sectors -= run;
+        }
     }
-    return i * 512;
+    spin_unlock_irqrestore(&hdd_lock, eflags);
+    return total;
+}
+
+uint32_t hdd_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    VFSIOVector vector = { .buffer = buffer, .length = buffer_size };
+    return hdd_readv(file, &vector, 1);
+}
+
+uint32_t hdd_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    VFSIOVector vector = { .buffer = buffer, .length = buffer_size };
+    return hdd_writev(file, &vector, 1);
+}
+
+// the transfer runs on the io queue thread so the submitter isn't held up while the drive is polled, hdd_lock keeps it safe without kernel_lock
+uint8_t hdd_submit(VFSFile* file, VFSRequest* request)
+{
+    (void)file;
+    return io_queue_push(request, 0);
 }
 
 void hdd_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg)
@@ -81,6 +129,9 @@ VFSFileOperations get_hdd_file_operations()
         .seek = (void*)hdd_seek,
         .tell = (void*)hdd_tell,
         .flush = (void*)hdd_flush,
+        .readv = (void*)hdd_readv,
+        .writev = (void*)hdd_writev,
+        .submit = (void*)hdd_submit,
     };
     return fops;
 }
@@ -1,12 +1,18 @@
 #include "heap.h"
 #include <memutils.h>
 #include <print.h>
+#include <spinlock.h>
 #include <stdint.h>
 
 uint8_t* heap = NULL;
 uint32_t heap_size = 0;
 BlockHeader* first_entry = NULL;
 
+// the heap is used from every cpu and from interrupt handlers
+spinlock_t heap_lock = SPINLOCK_INIT;
+
+void heap_free(void* ptr);
+
 void init_heap(uint8_t* buffer, uint32_t size)
 {
     heap = buffer;
@@ -59,7 +65,7 @@ BlockHeader* merge(BlockHeader* entry, uint8_t direction)
     }
 }
 
-void* malloc(uint32_t size)
+void* heap_alloc(uint32_t size)
 {
     BlockHeader* current = first_entry;
 
@@ -89,7 +95,15 @@ void* malloc(uint32_t size)
     return NULL;
 }
 
-void* malloc_aligned(uint32_t size, uint32_t alignment)
+void* malloc(uint32_t size)
+{
+    uint32_t eflags = spin_lock_irqsave(&heap_lock);
+    void* ptr = heap_alloc(size);
+    spin_unlock_irqrestore(&heap_lock, eflags);
+    return ptr;
+}
+
+void* heap_alloc_aligned(uint32_t size, uint32_t alignment)
 {
     BlockHeader* current = first_entry;
 
@@ -139,6 +153,14 @@ void* malloc_aligned(uint32_t size, uint32_t alignment)
     return NULL;
 }
 
+void* malloc_aligned(uint32_t size, uint32_t alignment)
+{
+    uint32_t eflags = spin_lock_irqsave(&heap_lock);
+    void* ptr = heap_alloc_aligned(size, alignment);
+    spin_unlock_irqrestore(&heap_lock, eflags);
+    return ptr;
+}
+
 void* calloc(uint32_t n, uint32_t size)
 {
     if (n > UINT32_MAX / size) {
@@ -147,7 +169,7 @@ void* calloc(uint32_t n, uint32_t size)
     return malloc(n * size);
 }
 
-void* realloc(void* ptr, uint32_t size)
+void* heap_realloc(void* ptr, uint32_t size)
 {
     BlockHeader* entry = (BlockHeader*)ptr - 1;
 
@@ -193,19 +215,34 @@ void* realloc(void* ptr, uint32_t size)
         }
     }
 
-    uint8_t* new_ptr = (uint8_t*)malloc(size);
+    uint8_t* new_ptr = (uint8_t*)heap_alloc(size);
     if (new_ptr == NULL) {
         return NULL;
     }
 
     memcpy(new_ptr, ptr, entry->size);
 
-    free((void*)(entry + 1));
+    heap_free((void*)(entry + 1));
+
+    return new_ptr;
+}
 
+void* realloc(void* ptr, uint32_t size)
+{
+    uint32_t eflags = spin_lock_irqsave(&heap_lock);
+    void* new_ptr = heap_realloc(ptr, size);
+    spin_unlock_irqrestore(&heap_lock, eflags);
     return new_ptr;
 }
 
 void free(void* ptr)
+{
+    uint32_t eflags = spin_lock_irqsave(&heap_lock);
+    heap_free(ptr);
+    spin_unlock_irqrestore(&heap_lock, eflags);
+}
+
+void heap_free(void* ptr)
 {
     if (ptr == NULL) {
         return;
@@ -0,0 +1,72 @@
+#include "image_cache.h"
+#include <heap.h>
+#include <pager.h>
+
+// most recently used first
+struct image* cached_images = NULL;
+uint32_t number_of_cached_images = 0;
+
+static void image_cache_remove(struct image* image)
+{
+    struct image** link = &cached_images;
+    while (*link != image) {
+        link = &(*link)->next;
+    }
+    *link = image->next;
+    image->next = NULL;
+    number_of_cached_images--;
+    vfs_release_inode(image->inode);
+    image_release(image);
+}
+
+struct image* image_cache_get(VFSIndexNode* inode)
+{
+    struct image** link = &cached_images;
+    for (; *link != NULL && (*link)->inode != inode; link = &(*link)->next)
+        ;
+    struct image* image = *link;
+    if (image == NULL) {
+        return NULL;
+    }
+    if (image->version != inode->version) {
+        image_cache_remove(image);
+        return NULL;
+    }
+    *link = image->next;
+    image->next = cached_images;
+    cached_images = image;
+    image->references++;
+    return image;
+}
+
+void image_cache_add(struct image* image)
+{
+    if (number_of_cached_images == IMAGE_CACHE_SIZE) {
+        struct image* last = cached_images;
+        while (last->next != NULL) {
+            last = last->next;
+        }
+        image_cache_remove(last);
+    }
+    // the inode stays while the cache points to it
+    vfs_hold_inode(image->inode);
+    image->references++;
+    image->next = cached_images;
+    cached_images = image;
+    number_of_cached_images++;
+}
+
+void image_release(struct image* image)
+{
+    if (--image->references != 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < image->number_of_pages; i++) {
+        free_physical_page(image->pages[i].physical_address);
+    }
+    if (image->library != NULL) {
+        image_release(image->library);
+    }
+    free(image->pages);
+    free(image);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+// programs loaded by spawn_process stay in memory keyed by their inode
+// read only pages are mapped into every instance, writable pages are copied from the cached copy, so warm launches don't read the disk
+#define IMAGE_CACHE_SIZE 8
+#define IMAGE_MAX_LAZY_RANGES 16
+
+struct image_page {
+    uintptr_t address;
+    void* physical_address;
+    uint32_t flags; // PAGE_WRITEABLE pages are copied for every instance
+};
+
+// .bss pages past the file bytes, zeroed when first touched
+struct image_lazy_range {
+    uintptr_t start;
+    uintptr_t end;
+    uint32_t flags;
+};
+
+struct image {
+    VFSIndexNode* inode;
+    uint32_t version; // of the inode when it was read
+    uint32_t references; // instances using the pages, plus one while it's in the cache
+    uint32_t entry;
+    uint32_t stack_size;
+    struct image_page* pages;
+    uint32_t number_of_pages;
+    struct image_lazy_range lazy_ranges[IMAGE_MAX_LAZY_RANGES];
+    uint32_t number_of_lazy_ranges;
+    struct image* library; // named by PT_INTERP and mapped with the program, the image holds a reference to it
+    struct image* next;
+};
+
+// the cache is only used with kernel_lock held
+
+// returns the cached image of the inode with a new reference, NULL if it isn't cached or the file changed since
+struct image* image_cache_get(VFSIndexNode* inode);
+// the cache takes its own reference, the least recently used image is dropped when it's full
+void image_cache_add(struct image* image);
+// the pages are given back once the last reference is dropped, the library reference with them
+void image_release(struct image* image);
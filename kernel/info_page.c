@@ -0,0 +1,104 @@
+#include "info_page.h"
+#include <heap.h>
+#include <memutils.h>
+#include <pager.h>
+#include <print.h>
+#include <process.h>
+#include <spinlock.h>
+
+// writers on different cpus can update the page of the same process
+spinlock_t info_page_lock = SPINLOCK_INIT;
+volatile uint32_t scheduler_ticks = 0;
+
+int info_page_create(struct process* process, struct process* parent)
+{
+    struct info_page* page = malloc_aligned(PAGE_SIZE, PAGE_SIZE);
+    if (page == NULL) {
+        printf("Failed to malloc the info page of process %d\n", process->id);
+        return 1;
+    }
+    memset(page, 0, PAGE_SIZE);
+    page->process_id = process->id;
+    page->parent_id = PROCESS_INVALID_ID;
+    page->stdout = process->stdout;
+    page->stdin = process->stdin;
+    page->stderr = process->stderr;
+    for (uint32_t i = 0; i < INFO_PAGE_CHILDREN; i++) {
+        page->children[i].id = PROCESS_INVALID_ID;
+    }
+    map_page(page, (void*)INFO_PAGE_ADDRESS, &process->page_table->pde, 0);
+    process->info_page = page;
+
+    if (parent == NULL || parent->info_page == NULL) {
+        return 0;
+    }
+    page->parent_id = parent->group_id;
+    process->parent_id = parent->group_id;
+
+    // reuse a free slot or the one of the oldest terminated child
+    struct info_page_child* slot = NULL;
+    for (uint32_t i = 0; i < INFO_PAGE_CHILDREN && slot == NULL; i++) {
+        if (parent->info_page->children[i].id == PROCESS_INVALID_ID) {
+            slot = &parent->info_page->children[i];
+        }
+    }
+    for (uint32_t i = 0; i < INFO_PAGE_CHILDREN && slot == NULL; i++) {
+        if (parent->info_page->children[i].state == PROCESS_TERMINATED) {
+            slot = &parent->info_page->children[i];
+        }
+    }
+    if (slot != NULL) {
+        slot->state = PROCESS_RUNNING;
+        slot->exit_code = 0;
+        slot->id = process->id;
+    }
+    return 0;
+}
+
+void info_page_destroy(struct process* process)
+{
+    if (process->info_page == NULL) {
+        return;
+    }
+    // the page belongs to the heap, so it can't be left for free_pde_table to give to the pager
+    unmap_page((void*)INFO_PAGE_ADDRESS, &process->page_table->pde);
+    free(process->info_page);
+    process->info_page = NULL;
+}
+
+void info_page_update_time(struct process* process, uint64_t now_ns)
+{
+    __asm__ volatile("lock incl %0" : "+m"(scheduler_ticks));
+    struct info_page* page = process->info_page;
+    if (page == NULL) {
+        return;
+    }
+    spin_lock(&info_page_lock);
+    page->sequence++;
+    __asm__ volatile("" ::: "memory");
+    page->monotonic_ns = now_ns;
+    page->ticks = scheduler_ticks;
+    __asm__ volatile("" ::: "memory");
+    page->sequence++;
+    spin_unlock(&info_page_lock);
+}
+
+void info_page_child_changed(struct process* process)
+{
+    if (process->parent_id == PROCESS_INVALID_ID) {
+        return;
+    }
+    struct process* parent = find_process(process->parent_id);
+    if (parent == NULL || parent->info_page == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < INFO_PAGE_CHILDREN; i++) {
+        struct info_page_child* slot = &parent->info_page->children[i];
+        if (slot->id == process->id) {
+            slot->exit_code = process->exit_code;
+            __asm__ volatile("" ::: "memory");
+            slot->state = process->state;
+            return;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+struct process;
+
+// read only page mapped at INFO_PAGE_ADDRESS in the table of every process and shared by its threads
+// the kernel writes it through its heap address, the process reads it without a system call
+// above the app memory, the low 4MB are shared by every table so it can't live there
+#define INFO_PAGE_ADDRESS 0xBFFFF000
+#define INFO_PAGE_CHILDREN 16
+
+struct info_page_child {
+    uint32_t id; // PROCESS_INVALID_ID for a free slot
+    uint32_t state; // PROCESS_RUNNING until the child terminates
+    uint32_t exit_code;
+    uint32_t reserved;
+};
+
+struct info_page {
+    volatile uint32_t sequence; // odd while the kernel updates the fields below it, readers retry until it's even and unchanged
+    uint32_t process_id;
+    uint32_t parent_id; // PROCESS_INVALID_ID if started by the kernel
+    VFSFile *stdout, *stdin, *stderr;
+    uint64_t monotonic_ns; // clock at the last time a thread of the process was scheduled
+    uint32_t ticks; // scheduler runs on all cpus since boot
+    uint32_t reserved;
+    struct info_page_child children[INFO_PAGE_CHILDREN]; // the last processes started by this one
+};
+
+// creates and maps the page of a new main thread and records it as a child of parent, returns 0 on success
+// parent can be a process without a page
+int info_page_create(struct process* process, struct process* parent);
+// unmaps and frees the page, must be called before the page table is freed
+void info_page_destroy(struct process* process);
+
+// called by the scheduler for the process it switches to
+void info_page_update_time(struct process* process, uint64_t now_ns);
+
+// updates the child slot in the parent's page after the state of a main thread changed
+void info_page_child_changed(struct process* process);
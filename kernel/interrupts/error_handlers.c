@@ -1,5 +1,6 @@
 #include "error_handlers.h"
 #include <exit.h>
+#include <pager.h>
 #include <print.h>
 #include <terminal/tty.h>
 
@@ -83,8 +84,14 @@ void general_protection(struct interrupt_frame* frame, uint32_t error_code)
 }
 void page_fault(struct interrupt_frame* frame, uint32_t error_code)
 {
+    uint32_t address;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(address));
+    // bit 0 of the error code is clear when the page wasn't present, it can be the first access to a lazily allocated page
+    if (!(error_code & 1) && fault_lazy_page((void*)address) == 0) {
+        return;
+    }
 
-    printf("page_fault error @ %x\n", frame->eip);
+    printf("page_fault error @ %x accessing %x (error code %x)\n", frame->eip, address, error_code);
     exit_kernel();
 }
 //
@@ -7,8 +7,9 @@
 #include <pic.h>
 #include <print.h>
 #include <process.h>
+#include <smp/apic.h>
+#include <smp/smp.h>
 #include <stdint.h>
-#include <time.h>
 #include <x86_64_structures.h>
 
 // void PIC_sendEOI(uint8_t irq)
@@ -19,44 +20,21 @@
 // 	outb(PIC1_COMMAND,PIC_EOI);
 // }
 
-volatile struct time time = { 0 };
-
-uint32_t irq0_timer_c(uint32_t* esp)
+void send_eoi()
 {
-    time.millisecond += 10;
-    if (time.millisecond > 1000) {
-        time.seconds += 1;
-        time.millisecond -= 1000;
+    if (apic_enabled()) {
+        lapic_eoi();
+    } else {
+        outb(PIC1_CMD, PIC_EOI);
     }
+}
 
-    struct process* current = get_current_process();
-    current->esp = (uint32_t)esp;
-
-    struct process* next = get_next_process();
-    while (next->state != PROCESS_RUNNING) {
-        switch (next->state) {
-        case PROCESS_RUNNING:
-            break;
-        case PROCESS_SLEEPING:
-            if (time.seconds >= next->wake_time.seconds && time.millisecond >= next->wake_time.millisecond) {
-                next->state = PROCESS_RUNNING;
-                break;
-            } else {
-                next = get_next_process();
-            }
-        case PROCESS_TERMINATED:
-            free_pde_table(&next->page_table->pde);
-            uint32_t id = next->id;
-            next = get_next_process();
-            remove_process(id);
-            break;
-        default:
-            next = get_next_process();
-            break;
-        }
-    }
+// with the apic every cpu gets its own timer interrupt, the time itself comes from the tsc
+uint32_t irq0_timer_c(uint32_t* esp)
+{
+    struct process* next = schedule((uintptr_t)esp);
 
-    outb(PIC1_CMD, PIC_EOI);
+    send_eoi();
     __asm__ volatile("mov %0, %%ebx\n\t" ::"r"(&next->page_table->pde));
     return next->esp;
 }
@@ -67,7 +45,7 @@ void irq1_keyboard(struct interrupt_frame* frame)
 
     on_event(scancode);
 
-    outb(PIC1_CMD, PIC_EOI);
+    send_eoi();
     return;
 }
 
@@ -77,3 +55,9 @@ void irq7_15_spurious(struct interrupt_frame* frame)
     outb(PIC2_CMD, PIC_EOI);
     return;
 }
+
+// the local apic doesn't expect an eoi for spurious interrupts
+void apic_spurious(struct interrupt_frame* frame)
+{
+    return;
+}
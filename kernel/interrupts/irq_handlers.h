@@ -7,4 +7,4 @@
 __attribute__((interrupt)) void irq0_timer(struct interrupt_frame *frame);
 __attribute__((interrupt)) void irq1_keyboard(struct interrupt_frame *frame);
 __attribute__((interrupt)) void irq7_15_spurious(struct interrupt_frame *frame);
-
+__attribute__((interrupt)) void apic_spurious(struct interrupt_frame *frame);
@@ -1,5 +1,6 @@
 [bits 32] 
 global syscall
+global syscall_sysenter
 extern syscall_c
 
 syscall:
@@ -14,3 +15,20 @@ syscall:
     popa
     sti
     iret
+
+; apps run in ring 0 so sysexit can't be used to return and the call stays on the caller's stack like int 0x40
+; the caller pushes ecx, edx and the return address and passes the stack pointer in ecx
+syscall_sysenter:
+    mov esp, ecx
+    mov edx, [esp + 4]
+    mov ecx, [esp + 8]
+    pusha
+
+    mov eax, esp
+    push eax
+    call syscall_c
+    add esp, 4
+
+    popa
+    sti
+    ret 8
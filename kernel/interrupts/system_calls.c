@@ -1,110 +1,387 @@
 #include "system_calls.h"
+#include <async_io.h>
+#include <clock.h>
+#include <filesystem/pipe.h>
 #include <filesystem/virtual-filesystem.h>
 #include <harddrive/ata.h>
 #include <heap.h>
+#include <io_ring.h>
 #include <keyboard/input.h>
+#include <loader.h>
+#include <msr.h>
 #include <pager.h>
 #include <print.h>
 #include <process.h>
+#include <spinlock.h>
 #include <stdint.h>
+#include <syscall_stats.h>
 #include <terminal/tty.h>
+#include <tsc.h>
 #include <x86_64_structures.h>
 
-void syscall_c(struct registers* regs)
+void syscall_open(struct registers* regs)
+{
+    regs->ebx = (uint32_t)vfs_open_file((char*)regs->ebx, regs->ecx);
+}
+
+void syscall_close(struct registers* regs)
+{
+    vfs_close_file((void*)regs->ebx);
+}
+
+void syscall_read(struct registers* regs)
+{
+    // pipes drop kernel_lock themselves while they wait
+    if (((VFSFile*)regs->ebx)->inode->type == VFS_PIPE) {
+        regs->eax = vfs_read((void*)regs->ebx, (void*)regs->edx, regs->ecx);
+        return;
+    }
+    spin_unlock(&kernel_lock);
+    __asm__("sti\n");
+    regs->eax = vfs_read((void*)regs->ebx, (void*)regs->edx, regs->ecx);
+    __asm__("cli\n");
+    spin_lock(&kernel_lock);
+}
+
+void syscall_write(struct registers* regs)
+{
+    regs->eax = vfs_write((void*)regs->ebx, (void*)regs->edx, regs->ecx);
+}
+
+void syscall_ioctl(struct registers* regs)
+{
+    vfs_ioctl((void*)regs->ebx, (uint32_t*)regs->ecx, (uint32_t*)regs->edx);
+}
+
+void syscall_seek(struct registers* regs)
+{
+    vfs_seek((void*)regs->ebx, regs->ecx, regs->edx);
+}
+
+void syscall_tell(struct registers* regs)
+{
+    regs->ecx = vfs_tell((void*)regs->ebx);
+}
+
+void syscall_create_file(struct registers* regs)
+{
+    regs->eax = vfs_create_regular_file((char*)regs->ebx);
+}
+
+void syscall_readv(struct registers* regs)
+{
+    if (((VFSFile*)regs->ebx)->inode->type == VFS_PIPE) {
+        regs->eax = vfs_readv((void*)regs->ebx, (VFSIOVector*)regs->edx, regs->ecx);
+        return;
+    }
+    spin_unlock(&kernel_lock);
+    __asm__("sti\n");
+    regs->eax = vfs_readv((void*)regs->ebx, (VFSIOVector*)regs->edx, regs->ecx);
+    __asm__("cli\n");
+    spin_lock(&kernel_lock);
+}
+
+void syscall_writev(struct registers* regs)
+{
+    regs->eax = vfs_writev((void*)regs->ebx, (VFSIOVector*)regs->edx, regs->ecx);
+}
+
+void syscall_pipe(struct registers* regs)
 {
-    switch (regs->eax) {
-        struct process* process;
-        struct process_init_data* pd;
-        PageTable* page_table;
+    VFSFile *read_end, *write_end;
+    if (pipe_create(&read_end, &write_end) != 0) {
+        regs->ebx = 0;
+        regs->ecx = 0;
+        return;
+    }
+    regs->ebx = (uint32_t)read_end;
+    regs->ecx = (uint32_t)write_end;
+}
+
+void syscall_stat(struct registers* regs)
+{
+    regs->eax = vfs_stat((char*)regs->ebx, (VFSStat*)regs->ecx);
+}
+
+void syscall_fstat(struct registers* regs)
+{
+    vfs_fstat((VFSFile*)regs->ebx, (VFSStat*)regs->ecx);
+}
+
+void syscall_get_directory_entries(struct registers* regs)
+{
+    regs->eax = vfs_get_directory_entries((char*)regs->ebx, (uint32_t*)regs->esi, (void*)regs->edx, regs->ecx);
+}
+
+void syscall_request_new_page(struct registers* regs)
+{
+    PageTable* page_table;
+    if (regs->edx == (uint32_t)PAGER_ERROR) {
+        page_table = get_current_process()->page_table;
+    } else {
+        page_table = (PageTable*)regs->edx;
+    }
+    regs->ebx = (uint32_t)new_page((void*)regs->ebx, &page_table->pde, 0);
+}
+
+void syscall_free_page(struct registers* regs)
+{
+    PageTable* page_table;
+    if (regs->edx == (uint32_t)PAGER_ERROR) {
+        page_table = get_current_process()->page_table;
+    } else {
+        page_table = (PageTable*)regs->edx;
+    }
+    free_page((void*)regs->ebx, &page_table->pde);
+}
 
-    case 0x00:
-        break;
+void syscall_create_new_table(struct registers* regs)
+{
+    regs->ebx = (uint32_t)soft_copy_table(kernel_table, 1);
+}
 
-    case 0x01:
-        break;
+void syscall_get_current_process(struct registers* regs)
+{
+    regs->ebx = (uint32_t)get_current_process();
+}
 
-    case 0x02:
-        regs->ebx = (uint32_t)vfs_open_file((char*)regs->ebx, regs->ecx);
-        break;
+void syscall_create_process(struct registers* regs)
+{
+    struct process_init_data* pd = (void*)regs->ebx;
+    regs->ebx = (uint32_t)create_process(pd->name, pd->initial_state, pd->entry_point, pd->stack_base_current_table, pd->stack_base_apps_table, pd->page_table, pd->stdout, pd->stdin, pd->stderr, 0, 0);
+}
 
-    case 0x03:
-        vfs_close_file((void*)regs->ebx);
-        break;
+// the scheduler never picks a terminated process again, so the system call doesn't return to the caller
+static void leave_terminated(struct process* process)
+{
+    account_system_call_exit(process);
+    spin_unlock(&kernel_lock);
+    while (1) {
+        yield_process();
+    }
+}
+
+void syscall_exit(struct registers* regs)
+{
+    struct process* process = get_current_process();
+    terminate_process(get_process_by_id(process->group_id), regs->ebx);
+    leave_terminated(process);
+}
+
+void syscall_create_thread(struct registers* regs)
+{
+    struct process* process = create_thread(get_current_process(), regs->ebx, regs->ecx, regs->edx);
+    regs->ebx = process == NULL ? (uint32_t)-1 : process->id;
+}
 
-    case 0x04:
+void syscall_exit_thread(struct registers* regs)
+{
+    struct process* process = get_current_process();
+    terminate_process(process, regs->ebx);
+    leave_terminated(process);
+}
+
+void syscall_join_thread(struct registers* regs)
+{
+    struct process* self = get_current_process();
+    struct process* process = get_process_by_id(regs->ebx);
+    if (process == NULL || process == self || process->group_id == process->id || process->group_id != self->group_id) {
+        regs->eax = 1;
+        return;
+    }
+    // wait for the scheduler to reap the thread, the exit code stays with the zombie until it's joined
+    while (process->state != PROCESS_ZOMBIE) {
+        spin_unlock(&kernel_lock);
+        yield_process();
+        spin_lock(&kernel_lock);
+        // another joiner or the exit of the main thread can remove the thread meanwhile
+        process = find_process(regs->ebx);
+        if (process == NULL || process->group_id == process->id || process->group_id != self->group_id) {
+            regs->eax = 1;
+            return;
+        }
+    }
+    regs->ebx = process->exit_code;
+    remove_process(process->id);
+    regs->eax = 0;
+}
+
+void syscall_set_priority(struct registers* regs)
+{
+    struct process* process = regs->ebx == PROCESS_INVALID_ID ? get_current_process() : get_process_by_id(regs->ebx);
+    regs->eax = process == NULL ? 1 : set_process_priority(process, regs->ecx);
+}
+
+void syscall_spawn(struct registers* regs)
+{
+    struct spawn_data* data = (void*)regs->ebx;
+    struct process* process = spawn_process(data->path, data->argv, data->stdout, data->stdin, data->stderr);
+    regs->ebx = process == NULL ? PROCESS_INVALID_ID : process->id;
+}
+
+void syscall_set_quantum(struct registers* regs)
+{
+    regs->eax = set_priority_quantum(regs->ebx, regs->ecx);
+}
+
+void syscall_clock_gettime(struct registers* regs)
+{
+    regs->eax = clock_gettime(regs->ebx, (struct clock_timespec*)regs->ecx);
+}
+
+void syscall_clock_getres(struct registers* regs)
+{
+    regs->eax = clock_getres(regs->ebx, (struct clock_timespec*)regs->ecx);
+}
+
+void syscall_sleep(struct registers* regs)
+{
+    struct process* process = get_current_process();
+    sleep_process(process, ((uint64_t)regs->ecx << 32) | regs->ebx);
+    while (process->state == PROCESS_SLEEPING) {
+        spin_unlock(&kernel_lock);
+        yield_process();
+        spin_lock(&kernel_lock);
+    }
+}
+
+void syscall_io_ring_setup(struct registers* regs)
+{
+    regs->ebx = (uint32_t)io_ring_setup(get_current_process(), regs->ebx);
+}
+
+void syscall_io_ring_enter(struct registers* regs)
+{
+    regs->eax = io_ring_enter(get_current_process(), regs->ebx);
+}
+
+void syscall_submit_io(struct registers* regs)
+{
+    regs->ebx = (uint32_t)async_io_submit(get_current_process(), (VFSFile*)regs->ebx, (void*)regs->edx, regs->ecx, regs->esi != 0);
+}
+
+void syscall_wait_io(struct registers* regs)
+{
+    regs->ebx = async_io_wait(get_current_process(), (struct async_io*)regs->ebx, regs->ecx != 0, &regs->eax);
+}
+
+// character devices can block on input, so they're read without kernel_lock like in the read system call
+// the destination is written with the lock held since it can be a file on the disk or in /tmp
+static uint32_t send_from_device(VFSFile* out, VFSFile* in, uint32_t length)
+{
+    uint8_t* buffer = malloc(VFS_TRANSFER_BUFFER_SIZE);
+    if (buffer == NULL) {
+        return 0;
+    }
+    uint32_t moved = 0;
+    while (moved < length) {
+        uint32_t part = length - moved < VFS_TRANSFER_BUFFER_SIZE ? length - moved : VFS_TRANSFER_BUFFER_SIZE;
+        spin_unlock(&kernel_lock);
         __asm__("sti\n");
-        regs->eax = vfs_read((void*)regs->ebx, (void*)regs->edx, regs->ecx);
+        uint32_t read = vfs_read(in, buffer, part);
         __asm__("cli\n");
-        break;
-
-    case 0x05:
-        regs->eax = vfs_write((void*)regs->ebx, (void*)regs->edx, regs->ecx);
-        break;
-
-    case 0x06:
-        vfs_ioctl((void*)regs->ebx, (uint32_t*)regs->ecx, (uint32_t*)regs->edx);
-        break;
-
-    case 0x07:
-        vfs_seek((void*)regs->ebx, regs->ecx, regs->edx);
-        break;
-
-    case 0x08:
-        regs->ecx = vfs_tell((void*)regs->ebx);
-        break;
-
-    case 0x09:
-        regs->eax = vfs_create_regular_file((char*)regs->ebx);
-        break;
-
-    case 0x0a:
-        break;
-        // nops
-    case 0x0f:
-        break;
-
-    case 0x10:
-        if (regs->edx == (uint32_t)PAGER_ERROR) {
-            page_table = get_current_process()->page_table;
-        } else {
-            page_table = (PageTable*)regs->edx;
+        spin_lock(&kernel_lock);
+        uint32_t written = read == 0 ? 0 : vfs_write(out, buffer, read);
+        moved += written;
+        if (read < part || written < read) {
+            break;
         }
-        regs->ebx = (uint32_t)new_page((void*)regs->ebx, &page_table->pde, 0);
-        break;
-
-    case 0x11:
-        if (regs->edx == (uint32_t)PAGER_ERROR) {
-            page_table = get_current_process()->page_table;
-        } else {
-            page_table = (PageTable*)regs->edx;
-        }
-        free_page((void*)regs->ebx, &page_table->pde);
-        break;
-
-    case 0x12:
-        regs->ebx = (uint32_t)soft_copy_table(kernel_table, 1);
-        break;
-
-    case 0x13:
-        break;
-        // nops
-    case 0x1f:
-        break;
-
-    case 0x20:
-        regs->ebx = (uint32_t)get_current_process();
-        break;
-
-    case 0x21:
-        pd = (void*)regs->ebx;
-        regs->ebx = (uint32_t)create_process(pd->name, pd->initial_state, pd->entry_point, pd->stack_base_current_table, pd->stack_base_apps_table, pd->page_table, pd->stdout, pd->stdin, pd->stderr);
-        break;
-
-    case 0x22:
-        process = get_current_process();
-        process->state = PROCESS_TERMINATED;
-        break;
     }
-    //__asm__ volatile("nop\n\t"); // needed for gcc as it made the wrong jump address
-    return;
+    free(buffer);
+    return moved;
+}
+
+void syscall_send_file(struct registers* regs)
+{
+    VFSFile* in = (VFSFile*)regs->ecx;
+    VFSFile* out = (VFSFile*)regs->ebx;
+    if (in->inode->type == VFS_CHARACTER_DEVICE && in->inode->file_operations.transfer == NULL) {
+        regs->eax = send_from_device(out, in, regs->edx);
+        return;
+    }
+    // everything else keeps kernel_lock, pipes drop it themselves while they wait
+    regs->eax = vfs_transfer(out, in, regs->edx);
+}
+
+// indexed by the number in eax, empty slots are nops
+syscall_handler syscall_table[SYSCALL_TABLE_SIZE] = {
+    [0x02] = syscall_open,
+    [0x03] = syscall_close,
+    [0x04] = syscall_read,
+    [0x05] = syscall_write,
+    [0x06] = syscall_ioctl,
+    [0x07] = syscall_seek,
+    [0x08] = syscall_tell,
+    [0x09] = syscall_create_file,
+    [0x0a] = syscall_readv,
+    [0x0b] = syscall_writev,
+    [0x0c] = syscall_stat,
+    [0x0d] = syscall_fstat,
+    [0x0e] = syscall_get_directory_entries,
+    [0x0f] = syscall_pipe,
+
+    [0x10] = syscall_request_new_page,
+    [0x11] = syscall_free_page,
+    [0x12] = syscall_create_new_table,
+
+    [0x20] = syscall_get_current_process,
+    [0x21] = syscall_create_process,
+    [0x22] = syscall_exit,
+    [0x23] = syscall_create_thread,
+    [0x24] = syscall_exit_thread,
+    [0x25] = syscall_join_thread,
+    [0x26] = syscall_set_priority,
+    [0x27] = syscall_spawn,
+    [0x28] = syscall_set_quantum,
+
+    [0x30] = syscall_clock_gettime,
+    [0x31] = syscall_clock_getres,
+    [0x32] = syscall_sleep,
+
+    [0x40] = syscall_io_ring_setup,
+    [0x41] = syscall_io_ring_enter,
+    [0x42] = syscall_submit_io,
+    [0x43] = syscall_wait_io,
+    [0x44] = syscall_send_file,
+};
+
+// system calls run one at a time under kernel_lock, blocking calls drop it while they wait
+void syscall_c(struct registers* regs)
+{
+    spin_lock(&kernel_lock);
+    account_system_call_enter(get_current_process());
+
+    if (regs->eax < SYSCALL_TABLE_SIZE && syscall_table[regs->eax] != NULL) {
+#ifdef SYSCALL_STATS
+        // handlers write their results over eax
+        uint32_t number = regs->eax;
+        uint64_t start = read_tsc();
+        syscall_table[number](regs);
+        syscall_stats_record(get_current_process(), number, read_tsc() - start);
+#else
+        syscall_table[regs->eax](regs);
+#endif
+    }
+
+    account_system_call_exit(get_current_process());
+    spin_unlock(&kernel_lock);
+}
+
+uint8_t cpu_has_sysenter()
+{
+    uint32_t eax = 1, ebx, ecx, edx;
+    __asm__ volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+    // sep bit, the first cpus reporting it had a broken version
+    return (edx & (1 << 11)) != 0 && !((eax >> 8 & 0xF) == 6 && (eax >> 4 & 0xF) < 3 && (eax & 0xF) < 3);
+}
+
+uint8_t init_sysenter(uintptr_t stack)
+{
+    if (!cpu_has_sysenter()) {
+        return 1;
+    }
+    write_msr(MSR_SYSENTER_CS, 0x8);
+    write_msr(MSR_SYSENTER_ESP, stack);
+    write_msr(MSR_SYSENTER_EIP, (uint32_t)syscall_sysenter);
+    return 0;
 }
@@ -1,7 +1,19 @@
-
 #pragma once
 
 #include "error_handlers.h"
+#include <x86_64_structures.h>
+
+#define SYSCALL_TABLE_SIZE 0x50
+
+typedef void (*syscall_handler)(struct registers* regs);
+
+extern syscall_handler syscall_table[SYSCALL_TABLE_SIZE];
 
 extern void syscall(struct interrupt_frame *frame);
 
+// entry point for the sysenter instruction, see system_calls.asm for the calling convention
+extern void syscall_sysenter();
+
+// points the sysenter msrs of the calling cpu at syscall_sysenter, stack is only used until the entry switches to the caller's stack
+// returns 1 if the cpu doesn't support sysenter, int 0x40 keeps working either way
+uint8_t init_sysenter(uintptr_t stack);
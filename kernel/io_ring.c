@@ -0,0 +1,231 @@
+#include "io_ring.h"
+#include <clock.h>
+#include <filesystem/virtual-filesystem.h>
+#include <memutils.h>
+#include <print.h>
+#include <spinlock.h>
+
+#define IO_RING_MASK (IO_RING_ENTRIES - 1)
+
+// the polling thread sleeps between empty polls and suspends itself after being idle for a while
+#define IO_RING_POLL_INTERVAL_NS 1000000ull
+#define IO_RING_POLL_IDLE_NS 50000000ull
+
+uint32_t io_ring_run(struct io_ring_submission* submission, VFSFile* file, uint32_t* result)
+{
+    *result = 0;
+    if (submission->operation != IO_RING_NOP && submission->operation != IO_RING_OPEN && file == NULL) {
+        return IO_RING_FAILED;
+    }
+
+    switch (submission->operation) {
+    case IO_RING_NOP:
+        break;
+    case IO_RING_OPEN:
+        *result = (uint32_t)vfs_open_file((char*)submission->address, submission->argument);
+        return *result == 0 ? IO_RING_FAILED : IO_RING_SUCCESS;
+    case IO_RING_READ:
+        // same as the read system call, reads can block on input and pipes drop kernel_lock themselves
+        if (file->inode->type == VFS_PIPE) {
+            *result = vfs_read(file, (void*)submission->address, submission->length);
+            break;
+        }
+        spin_unlock(&kernel_lock);
+        __asm__("sti\n");
+        *result = vfs_read(file, (void*)submission->address, submission->length);
+        __asm__("cli\n");
+        spin_lock(&kernel_lock);
+        break;
+    case IO_RING_WRITE:
+        *result = vfs_write(file, (void*)submission->address, submission->length);
+        break;
+    case IO_RING_SEEK:
+        vfs_seek(file, submission->length, submission->argument);
+        break;
+    case IO_RING_IOCTL:
+        vfs_ioctl(file, (uint32_t*)submission->address, (uint32_t*)submission->argument);
+        break;
+    case IO_RING_CLOSE:
+        vfs_close_file(file);
+        break;
+    default:
+        return IO_RING_FAILED;
+    }
+    return IO_RING_SUCCESS;
+}
+
+void io_ring_complete(struct io_ring* ring, uint32_t user_data, uint32_t result, uint32_t status)
+{
+    struct io_ring_completion* completion = &ring->completions[ring->completion_tail & IO_RING_MASK];
+    completion->user_data = user_data;
+    completion->result = result;
+    completion->status = status;
+    // the entry has to be visible before the process sees the new tail
+    __asm__ volatile("" ::: "memory");
+    ring->completion_tail++;
+}
+
+// runs length entries starting at the submission head, space for every completion was checked by the caller
+void io_ring_run_chain(struct io_ring* ring, uint32_t length)
+{
+    VFSFile* chain_file = NULL;
+    uint8_t failed = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        // copied since the process can change the entry while it runs
+        struct io_ring_submission submission = ring->submissions[ring->submission_head & IO_RING_MASK];
+        ring->submission_head++;
+
+        VFSFile* file = (submission.flags & IO_RING_CHAIN_FILE) ? chain_file : (VFSFile*)submission.file;
+        uint32_t result = 0;
+        uint32_t status = IO_RING_CANCELED;
+        // closing the file opened by the chain still happens after a failure so it isn't leaked
+        if (!failed || (submission.operation == IO_RING_CLOSE && file != NULL && file == chain_file)) {
+            status = io_ring_run(&submission, file, &result);
+        }
+        if (submission.operation == IO_RING_OPEN && status == IO_RING_SUCCESS) {
+            chain_file = (VFSFile*)result;
+        } else if (submission.operation == IO_RING_CLOSE && status == IO_RING_SUCCESS && file == chain_file) {
+            chain_file = NULL;
+        }
+        failed |= status != IO_RING_SUCCESS;
+
+        if (status != IO_RING_SUCCESS || !(submission.flags & IO_RING_SKIP_SUCCESS)) {
+            io_ring_complete(ring, submission.user_data, result, status);
+        }
+    }
+}
+
+// takes chains from the submission ring while the completion ring has space for them
+// only one cpu works on a ring at a time since reads drop kernel_lock, the one already running picks up the new entries
+uint32_t io_ring_submit(struct process* leader)
+{
+    struct io_ring* ring = leader->io_ring;
+    if (leader->io_ring_busy) {
+        return 0;
+    }
+    leader->io_ring_busy = 1;
+
+    uint32_t consumed = 0;
+    while (ring->submission_head != ring->submission_tail) {
+        uint32_t pending = ring->submission_tail - ring->submission_head;
+        if (pending > IO_RING_ENTRIES) {
+            printf("Process %d corrupted its io ring, dropping %d submissions\n", leader->id, pending);
+            ring->submission_head = ring->submission_tail;
+            break;
+        }
+
+        // a chain ends at the first entry without IO_RING_LINK or at the last queued entry
+        uint32_t length = 1;
+        while (length < pending && (ring->submissions[(ring->submission_head + length - 1) & IO_RING_MASK].flags & IO_RING_LINK)) {
+            length++;
+        }
+        if (IO_RING_ENTRIES - (ring->completion_tail - ring->completion_head) < length) {
+            break;
+        }
+
+        io_ring_run_chain(ring, length);
+        consumed += length;
+    }
+
+    leader->io_ring_busy = 0;
+    return consumed;
+}
+
+// entry of the polling thread, create_thread passes the ring in edx which regparm takes as the second argument
+__attribute__((regparm(3))) void io_ring_poll(uint32_t unused, struct io_ring* ring)
+{
+    (void)unused;
+    struct process* self = get_current_process();
+    uint64_t idle_since = clock_monotonic_ns();
+    while (1) {
+        uint32_t eflags = spin_lock_irqsave(&kernel_lock);
+        if (self->state == PROCESS_TERMINATED) {
+            // the process exited while this thread waited for the lock
+            spin_unlock_irqrestore(&kernel_lock, eflags);
+            yield_process();
+            continue;
+        }
+        struct process* leader = get_process_by_id(self->group_id);
+        uint64_t now = clock_monotonic_ns();
+        if (io_ring_submit(leader) != 0) {
+            idle_since = now;
+        } else if (now - idle_since < IO_RING_POLL_IDLE_NS) {
+            sleep_process(self, IO_RING_POLL_INTERVAL_NS);
+        } else {
+            ring->flags |= IO_RING_NEED_WAKEUP;
+            // pairs with the fence in the process between queueing and reading the flags
+            __sync_synchronize();
+            if (ring->submission_head == ring->submission_tail) {
+                self->state = PROCESS_SUSPENDED;
+            } else {
+                ring->flags &= ~IO_RING_NEED_WAKEUP;
+            }
+            idle_since = now;
+        }
+        spin_unlock_irqrestore(&kernel_lock, eflags);
+
+        if (self->state != PROCESS_RUNNING) {
+            yield_process();
+        }
+    }
+}
+
+struct io_ring* io_ring_setup(struct process* process, uint32_t flags)
+{
+    struct process* leader = get_process_by_id(process->group_id);
+    if (leader == NULL || leader->io_ring != NULL) {
+        return NULL;
+    }
+
+    struct io_ring* ring = new_page(PAGER_ERROR, &leader->page_table->pde, 0);
+    if (ring == PAGER_ERROR) {
+        printf("Failed to allocate io ring for process %d\n", leader->id);
+        return NULL;
+    }
+    memset(ring, 0, PAGE_SIZE);
+
+    if (flags & IO_RING_POLL) {
+        struct process* poller = create_thread(leader, (uint32_t)io_ring_poll, 0, (uint32_t)ring);
+        if (poller == NULL) {
+            free_page(ring, &leader->page_table->pde);
+            return NULL;
+        }
+        poller->detached = 1;
+        leader->io_ring_poller = poller->id;
+        ring->flags = IO_RING_POLL;
+    }
+    leader->io_ring = ring;
+    return ring;
+}
+
+uint32_t io_ring_enter(struct process* process, uint32_t min_complete)
+{
+    struct process* leader = get_process_by_id(process->group_id);
+    if (leader == NULL || leader->io_ring == NULL) {
+        return 0;
+    }
+    struct io_ring* ring = leader->io_ring;
+
+    if (ring->flags & IO_RING_NEED_WAKEUP) {
+        ring->flags &= ~IO_RING_NEED_WAKEUP;
+        struct process* poller = get_process_by_id(leader->io_ring_poller);
+        if (poller != NULL && poller->state == PROCESS_SUSPENDED) {
+            wake_process(poller);
+        }
+    }
+
+    uint32_t consumed = io_ring_submit(leader);
+
+    // without a polling thread everything that fit was completed above
+    if (ring->flags & IO_RING_POLL) {
+        if (min_complete > IO_RING_ENTRIES) {
+            min_complete = IO_RING_ENTRIES;
+        }
+        while (ring->completion_tail - ring->completion_head < min_complete && process->state == PROCESS_RUNNING) {
+            spin_unlock(&kernel_lock);
+            yield_process();
+            spin_lock(&kernel_lock);
+        }
+    }
+    return consumed;
+}
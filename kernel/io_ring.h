@@ -0,0 +1,80 @@
+#pragma once
+
+#include <pager.h>
+#include <process.h>
+#include <stdint.h>
+
+// pair of rings shared with a process, the process queues file operations in the submission ring
+// and the kernel posts their results in the completion ring
+// indices run freely and are masked with IO_RING_ENTRIES - 1 when used
+
+#define IO_RING_ENTRIES 64
+
+enum {
+    IO_RING_NOP = 0,
+    IO_RING_OPEN = 1, // address = path, argument = flags, result = file
+    IO_RING_READ = 2, // address = buffer, length = buffer size, result = bytes read
+    IO_RING_WRITE = 3, // address = buffer, length = buffer size, result = bytes written
+    IO_RING_SEEK = 4, // length = offset, argument = whence
+    IO_RING_IOCTL = 5, // address = command pointer, argument = arg pointer
+    IO_RING_CLOSE = 6,
+};
+
+// submission flags
+enum {
+    IO_RING_LINK = 1, // the next entry is part of the same chain and only runs if this one succeeded
+    IO_RING_CHAIN_FILE = 1 << 1, // use the file opened earlier in the chain instead of file
+    IO_RING_SKIP_SUCCESS = 1 << 2, // only post a completion if the entry didn't succeed
+};
+
+// ring flags
+enum {
+    IO_RING_POLL = 1, // a kernel thread takes submissions without a system call
+    IO_RING_NEED_WAKEUP = 1 << 1, // the polling thread went to sleep, io_ring_enter has to be called to wake it
+};
+
+// completion status
+enum {
+    IO_RING_SUCCESS = 0,
+    IO_RING_FAILED = 1,
+    IO_RING_CANCELED = 2, // an earlier entry of the chain failed
+};
+
+struct io_ring_submission {
+    uint8_t operation;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t file; // VFSFile
+    uint32_t address;
+    uint32_t length;
+    uint32_t argument;
+    uint32_t user_data; // copied into the completion
+};
+
+struct io_ring_completion {
+    uint32_t user_data;
+    uint32_t result;
+    uint32_t status;
+    uint32_t reserved;
+};
+
+struct io_ring {
+    volatile uint32_t submission_head; // advanced by the kernel
+    volatile uint32_t submission_tail; // advanced by the process
+    volatile uint32_t completion_head; // advanced by the process
+    volatile uint32_t completion_tail; // advanced by the kernel
+    volatile uint32_t flags;
+    uint32_t reserved[3];
+    struct io_ring_submission submissions[IO_RING_ENTRIES];
+    struct io_ring_completion completions[IO_RING_ENTRIES];
+};
+
+_Static_assert(sizeof(struct io_ring) <= PAGE_SIZE, "io ring has to fit in a page");
+
+// maps a ring into the process' address space, every thread of the process shares it
+// flags can be IO_RING_POLL, returns NULL on fail or if the process already has a ring
+struct io_ring* io_ring_setup(struct process* process, uint32_t flags);
+
+// runs the queued submissions and wakes the polling thread, then waits for min_complete completions if the ring is polled
+// returns the number of submissions taken, expects kernel_lock to be held
+uint32_t io_ring_enter(struct process* process, uint32_t min_complete);
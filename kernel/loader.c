@@ -0,0 +1,398 @@
+#include "loader.h"
+#include <elf.h>
+#include <heap.h>
+#include <image_cache.h>
+#include <memutils.h>
+#include <pager.h>
+#include <print.h>
+#include <process.h>
+
+// state while an image is read from its file
+struct loader {
+    VFSFile* file;
+    PDETable* current_table;
+    struct image* image;
+    void** aliases; // where the kernel writes the image pages, same order as image->pages
+};
+
+// maps a new page at address in table, alias_table gets a second mapping the kernel can write through
+// returns the alias, the address in table without alias_table, or PAGER_ERROR if there's no memory left
+static void* load_page(PDETable* table, uintptr_t address, uint32_t flags, PDETable* alias_table)
+{
+    void* physical_address = alloc_page();
+    if (physical_address == PAGER_ERROR) {
+        return PAGER_ERROR;
+    }
+    map_page(physical_address, (void*)address, table, flags);
+    if (alias_table == NULL) {
+        return (void*)address;
+    }
+    return map_free_address(physical_address, alias_table, PAGE_WRITEABLE | PAGE_WRITE_THROUGH);
+}
+
+// returns the alias of the image page at address, pages shared by two segments get the flags of both
+// new pages are zeroed when the segment doesn't fill them
+static void* get_image_page(struct loader* loader, uintptr_t address, uint32_t flags, uint8_t partial)
+{
+    struct image* image = loader->image;
+    for (uint32_t i = 0; i < image->number_of_pages; i++) {
+        if (image->pages[i].address == address) {
+            image->pages[i].flags |= flags;
+            return loader->aliases[i];
+        }
+    }
+    void* physical_address = alloc_page();
+    if (physical_address == PAGER_ERROR) {
+        return PAGER_ERROR;
+    }
+    void* alias = map_free_address(physical_address, loader->current_table, PAGE_WRITEABLE | PAGE_WRITE_THROUGH);
+    if (alias == PAGER_ERROR) {
+        free_physical_page(physical_address);
+        return PAGER_ERROR;
+    }
+    if (partial) {
+        memset(alias, 0, PAGE_SIZE);
+    }
+    image->pages[image->number_of_pages].address = address;
+    image->pages[image->number_of_pages].physical_address = physical_address;
+    image->pages[image->number_of_pages].flags = flags;
+    loader->aliases[image->number_of_pages] = alias;
+    image->number_of_pages++;
+    return alias;
+}
+
+// reads the file bytes of the segment with one vectored read, the .bss pages after them are left for map_image
+static uint8_t load_segment(struct loader* loader, struct elf_program_header* header)
+{
+    uintptr_t start = header->virtual_address;
+    uintptr_t file_end = start + header->file_size;
+    uintptr_t memory_end = start + header->memory_size;
+    uintptr_t first_page = start & ~(PAGE_SIZE - 1);
+    uintptr_t lazy_start = first_page;
+    uint32_t flags = PAGE_WRITE_THROUGH | (header->flags & ELF_SEGMENT_WRITEABLE ? PAGE_WRITEABLE : 0);
+
+    if (header->file_size != 0) {
+        lazy_start = (file_end + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        uint32_t count = (lazy_start - first_page) / PAGE_SIZE;
+        VFSIOVector* vectors = malloc(sizeof(VFSIOVector) * count);
+        if (vectors == NULL) {
+            return 1;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uintptr_t page = first_page + i * PAGE_SIZE;
+            uintptr_t from = page < start ? start : page;
+            uintptr_t to = page + PAGE_SIZE > file_end ? file_end : page + PAGE_SIZE;
+            // the page with the end of the file bytes is zeroed, so is the start of .bss in it
+            uint8_t* alias = get_image_page(loader, page, flags, from != page || to != page + PAGE_SIZE);
+            if (alias == PAGER_ERROR) {
+                free(vectors);
+                return 1;
+            }
+            vectors[i].buffer = alias + (from - page);
+            vectors[i].length = to - from;
+        }
+        vfs_seek(loader->file, header->offset, VFS_BEG);
+        uint32_t read = vfs_readv(loader->file, vectors, count);
+        free(vectors);
+        if (read != header->file_size) {
+            return 1;
+        }
+    }
+
+    if (lazy_start < memory_end) {
+        struct image* image = loader->image;
+        if (image->number_of_lazy_ranges == IMAGE_MAX_LAZY_RANGES) {
+            return 1;
+        }
+        image->lazy_ranges[image->number_of_lazy_ranges].start = lazy_start;
+        image->lazy_ranges[image->number_of_lazy_ranges].end = memory_end;
+        image->lazy_ranges[image->number_of_lazy_ranges].flags = flags;
+        image->number_of_lazy_ranges++;
+    }
+    return 0;
+}
+
+// copies the strings and the pointers to them to the end of the top stack page, returns the offset of the pointers in the page
+static uint32_t copy_arguments(uint8_t* stack_page, char** argv, uint32_t* argc)
+{
+    uint32_t count = 0;
+    uint32_t strings_size = 0;
+    for (; argv != NULL && argv[count] != NULL; count++) {
+        strings_size += strlen(argv[count]) + 1;
+        if (count == LOADER_MAX_ARGUMENTS || strings_size > LOADER_MAX_ARGUMENTS_SIZE) {
+            return (uint32_t)-1;
+        }
+    }
+    uint32_t offset = PAGE_SIZE - ((strings_size + 3) & ~3) - (count + 1) * sizeof(char*);
+    uint32_t* pointers = (uint32_t*)(stack_page + offset);
+    uint32_t string_offset = offset + (count + 1) * sizeof(char*);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t length = strlen(argv[i]) + 1;
+        memcpy(stack_page + string_offset, argv[i], length);
+        pointers[i] = LOADER_STACK_TOP - PAGE_SIZE + string_offset;
+        string_offset += length;
+    }
+    pointers[count] = 0;
+    *argc = count;
+    return offset;
+}
+
+// reads and checks the headers, returns the program headers or NULL if the file isn't a program that can be loaded
+static struct elf_program_header* read_headers(VFSFile* file, struct elf_header* header)
+{
+    if (vfs_read(file, header, sizeof(struct elf_header)) != sizeof(struct elf_header)
+        || header->magic != ELF_MAGIC || header->class != ELF_CLASS_32 || header->data != ELF_DATA_LITTLE_ENDIAN
+        || header->type != ELF_TYPE_EXECUTABLE || header->machine != ELF_MACHINE_386
+        || header->program_header_size != sizeof(struct elf_program_header)
+        || header->program_header_count == 0 || header->program_header_count > LOADER_MAX_SEGMENTS) {
+        return NULL;
+    }
+    uint32_t size = header->program_header_count * sizeof(struct elf_program_header);
+    struct elf_program_header* program_headers = malloc(size);
+    if (program_headers == NULL) {
+        return NULL;
+    }
+    vfs_seek(file, header->program_header_offset, VFS_BEG);
+    if (vfs_read(file, program_headers, size) != size) {
+        free(program_headers);
+        return NULL;
+    }
+    return program_headers;
+}
+
+static struct image* get_image(char* path, uint8_t is_library);
+
+// reads the library path from the PT_INTERP segment and loads it, returns NULL if it can't be loaded
+static struct image* load_library(VFSFile* file, struct elf_program_header* segment, char* path)
+{
+    char library_path[LOADER_MAX_LIBRARY_PATH + 1] = { 0 };
+    if (segment->file_size > LOADER_MAX_LIBRARY_PATH) {
+        printf("Library path of %s is too long\n", path);
+        return NULL;
+    }
+    vfs_seek(file, segment->offset, VFS_BEG);
+    if (vfs_read(file, library_path, segment->file_size) != segment->file_size) {
+        return NULL;
+    }
+    struct image* library = get_image(library_path, 1);
+    if (library == NULL) {
+        printf("Failed to load %s for %s\n", library_path, path);
+    }
+    return library;
+}
+
+// reads the program into pages owned by the image, returns NULL if it can't be loaded
+static struct image* load_image(VFSFile* file, char* path, uint8_t is_library)
+{
+    struct elf_header header;
+    struct elf_program_header* program_headers = read_headers(file, &header);
+    if (program_headers == NULL) {
+        printf("%s is not an elf32 executable\n", path);
+        return NULL;
+    }
+
+    uint32_t stack_size = LOADER_STACK_SIZE;
+    uint32_t max_pages = 0;
+    struct elf_program_header* interpreter = NULL;
+    for (uint32_t i = 0; i < header.program_header_count; i++) {
+        struct elf_program_header* segment = &program_headers[i];
+        if (segment->type == ELF_SEGMENT_INTERP && segment->file_size > 1) {
+            interpreter = segment;
+        } else if (segment->type == ELF_SEGMENT_GNU_STACK && segment->memory_size != 0) {
+            stack_size = segment->memory_size > LOADER_MAX_STACK_SIZE ? LOADER_MAX_STACK_SIZE : (segment->memory_size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        } else if (segment->type == ELF_SEGMENT_LOAD && segment->file_size != 0) {
+            max_pages += ((segment->virtual_address + segment->file_size + PAGE_SIZE - 1) >> 12) - (segment->virtual_address >> 12);
+        }
+    }
+    for (uint32_t i = 0; i < header.program_header_count; i++) {
+        struct elf_program_header* segment = &program_headers[i];
+        if (segment->type == ELF_SEGMENT_LOAD && segment->memory_size != 0
+            && (segment->virtual_address < LOADER_IMAGE_ADDRESS || segment->virtual_address > LOADER_STACK_TOP - stack_size
+                || segment->file_size > segment->memory_size || segment->memory_size > LOADER_STACK_TOP - stack_size - segment->virtual_address)) {
+            printf("Segment %d of %s is outside of the app memory\n", i, path);
+            free(program_headers);
+            return NULL;
+        }
+    }
+    if (interpreter != NULL && is_library) {
+        printf("Library %s needs another library\n", path);
+        free(program_headers);
+        return NULL;
+    }
+
+    struct image* image = malloc(sizeof(struct image));
+    struct loader loader = {
+        .file = file,
+        .current_table = get_loaded_page_table(),
+        .image = image,
+        .aliases = malloc(sizeof(void*) * (max_pages == 0 ? 1 : max_pages)),
+    };
+    if (image != NULL) {
+        memset(image, 0, sizeof(struct image));
+        image->pages = malloc(sizeof(struct image_page) * (max_pages == 0 ? 1 : max_pages));
+    }
+    if (image == NULL || image->pages == NULL || loader.aliases == NULL) {
+        if (image != NULL) {
+            free(image->pages);
+        }
+        free(image);
+        free(loader.aliases);
+        free(program_headers);
+        return NULL;
+    }
+    image->inode = file->inode;
+    image->version = file->inode->version;
+    image->references = 1;
+    image->entry = header.entry;
+    image->stack_size = stack_size;
+
+    uint8_t failed = 0;
+    for (uint32_t i = 0; i < header.program_header_count && !failed; i++) {
+        if (program_headers[i].type == ELF_SEGMENT_LOAD && program_headers[i].memory_size != 0 && load_segment(&loader, &program_headers[i]) != 0) {
+            printf("Failed to load segment %d of %s\n", i, path);
+            failed = 1;
+        }
+    }
+    if (!failed && interpreter != NULL) {
+        image->library = load_library(file, interpreter, path);
+        failed = image->library == NULL;
+    }
+    for (uint32_t i = 0; i < image->number_of_pages; i++) {
+        unmap_page(loader.aliases[i], loader.current_table);
+    }
+    free(loader.aliases);
+    free(program_headers);
+    if (failed) {
+        image_release(image);
+        return NULL;
+    }
+    return image;
+}
+
+// returns the image of the program at path with a new reference, it's only read from the file if the cached one is missing or old
+static struct image* get_image(char* path, uint8_t is_library)
+{
+    VFSFile* file = vfs_open_file(path, VFS_READ);
+    if (file == NULL) {
+        return NULL;
+    }
+    struct image* image = image_cache_get(file->inode);
+    if (image == NULL) {
+        image = load_image(file, path, is_library);
+        if (image != NULL) {
+            image_cache_add(image);
+        }
+    }
+    vfs_close_file(file);
+    return image;
+}
+
+// maps the read only pages of the image into the table and gives it copies of the writable ones
+// fails if a page is already used, so a library can't overlap the program
+static uint8_t map_image(struct image* image, PDETable* table, PDETable* current_table)
+{
+    for (uint32_t i = 0; i < image->number_of_pages; i++) {
+        struct image_page* page = &image->pages[i];
+        if (virt_to_phys(page->address, table) != (uintptr_t)PAGER_ERROR) {
+            return 1;
+        }
+        if (!(page->flags & PAGE_WRITEABLE)) {
+            map_page(page->physical_address, (void*)page->address, table, page->flags | PAGE_SHARED);
+            continue;
+        }
+        void* copy = load_page(table, page->address, page->flags, current_table);
+        if (copy == PAGER_ERROR) {
+            return 1;
+        }
+        void* original = map_free_address(page->physical_address, current_table, 0);
+        if (original == PAGER_ERROR) {
+            unmap_page(copy, current_table);
+            return 1;
+        }
+        memcpy(copy, original, PAGE_SIZE);
+        unmap_page(original, current_table);
+        unmap_page(copy, current_table);
+    }
+    for (uint32_t i = 0; i < image->number_of_lazy_ranges; i++) {
+        struct image_lazy_range* range = &image->lazy_ranges[i];
+        for (uintptr_t page = range->start; page < range->end; page += PAGE_SIZE) {
+            if (virt_to_phys(page, table) == (uintptr_t)PAGER_ERROR) {
+                map_lazy_page((void*)page, table, range->flags);
+            }
+        }
+    }
+    return 0;
+}
+
+struct process* spawn_process(char* path, char** argv, VFSFile* stdout, VFSFile* stdin, VFSFile* stderr)
+{
+    struct image* image = get_image(path, 0);
+    if (image == NULL) {
+        return NULL;
+    }
+
+    PDETable* current_table = get_loaded_page_table();
+    PageTable* table = soft_copy_table(kernel_table, 1);
+    if (table == PAGER_ERROR) {
+        image_release(image);
+        return NULL;
+    }
+    struct process* process = NULL;
+    void* stack_page = PAGER_ERROR;
+
+    if ((image->library != NULL && map_image(image->library, &table->pde, current_table) != 0)
+        || map_image(image, &table->pde, current_table) != 0) {
+        printf("Failed to map %s\n", path);
+        goto fail;
+    }
+
+    // the stack can't be lazy, faults push to the stack they happen on
+    for (uintptr_t address = LOADER_STACK_TOP - image->stack_size; address < LOADER_STACK_TOP - PAGE_SIZE; address += PAGE_SIZE) {
+        if (load_page(&table->pde, address, PAGE_WRITEABLE | PAGE_WRITE_THROUGH, NULL) == PAGER_ERROR) {
+            goto fail;
+        }
+    }
+    stack_page = load_page(&table->pde, LOADER_STACK_TOP - PAGE_SIZE, PAGE_WRITEABLE | PAGE_WRITE_THROUGH, current_table);
+    if (stack_page == PAGER_ERROR) {
+        goto fail;
+    }
+
+    uint32_t argc;
+    uint32_t arguments_offset = copy_arguments(stack_page, argv, &argc);
+    if (arguments_offset == (uint32_t)-1) {
+        printf("Too many arguments for %s\n", path);
+        goto fail;
+    }
+    // the initial register frame goes right below argv
+    uint32_t stack_offset = arguments_offset & ~0xF;
+
+    char name[64] = { 0 };
+    char* base_name = path;
+    for (char* c = path; *c != '\0'; c++) {
+        if (*c == '/' && c[1] != '\0') {
+            base_name = c + 1;
+        }
+    }
+    uint32_t name_length = strlen(base_name);
+    if (name_length > sizeof(name) - 1) {
+        name_length = sizeof(name) - 1;
+    }
+    memcpy(name, base_name, name_length);
+
+    process = create_process(name, PROCESS_RUNNING, image->entry, (uint32_t)stack_page + stack_offset, LOADER_STACK_TOP - PAGE_SIZE + stack_offset,
+        table, stdout, stdin, stderr, argc, LOADER_STACK_TOP - PAGE_SIZE + arguments_offset);
+    if (process != NULL) {
+        // released when the process is reaped
+        process->image = image;
+    }
+
+fail:
+    if (stack_page != PAGER_ERROR) {
+        unmap_page(stack_page, current_table);
+    }
+    if (process == NULL) {
+        free_pde_table(&table->pde);
+        image_release(image);
+    }
+    return process;
+}
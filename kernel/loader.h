@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <info_page.h>
+#include <stdint.h>
+
+struct process;
+
+// programs are elf32 executables, the PT_LOAD segments have to be between LOADER_IMAGE_ADDRESS and the stack
+// apps are linked for LOADER_IMAGE_ADDRESS (see apps/linker.ld)
+#define LOADER_IMAGE_ADDRESS 0x400000
+// the stack ends right below the info page, argv is copied to its top
+// the size comes from the PT_GNU_STACK header when the app is linked with -z stack-size
+#define LOADER_STACK_TOP INFO_PAGE_ADDRESS
+#define LOADER_STACK_SIZE 0x4000
+#define LOADER_MAX_STACK_SIZE 0x100000
+#define LOADER_MAX_SEGMENTS 16
+#define LOADER_MAX_ARGUMENTS 32
+#define LOADER_MAX_ARGUMENTS_SIZE 1024
+// programs can name one library in PT_INTERP, it's mapped at the address it was linked for and can't need another one
+#define LOADER_MAX_LIBRARY_PATH 64
+
+// argument of the spawn system call
+struct spawn_data {
+    char* path;
+    char** argv;
+    VFSFile *stdout, *stdin, *stderr;
+};
+
+// loads the program at path into a new address space and starts it with ecx set to argc and edx to argv
+// segments without the writeable flag are mapped read only, .bss pages past the file bytes are only allocated when touched
+// the library named by the program is mapped the same way before it
+// argv ends with NULL and can be NULL, the files are given to the new process
+// must be called with kernel_lock held, returns NULL on fail
+struct process* spawn_process(char* path, char** argv, VFSFile* stdout, VFSFile* stdin, VFSFile* stderr);
@@ -1,5 +1,8 @@
+#include <clock.h>
 #include <exit.h>
 #include <filesystem/estros-fs.h>
+#include <filesystem/io-queue.h>
+#include <filesystem/tmpfs.h>
 #include <filesystem/virtual-filesystem.h>
 #include <harddrive/ata.h>
 #include <harddrive/hdd.h>
@@ -11,15 +14,20 @@
 #include <interrupts/system_calls.h>
 #include <keyboard/input.h>
 #include <keyboard/keyboard.h>
+#include <loader.h>
 #include <memutils.h>
 #include <pager.h>
 #include <pic.h>
 #include <pit.h>
 #include <print.h>
 #include <process.h>
+#include <smp/smp.h>
+#include <spinlock.h>
 #include <stdint.h>
+#include <sysfs/proc.h>
+#include <sysfs/syscalls.h>
 #include <terminal/tty.h>
-#include <time.h>
+#include <timer.h>
 #include <tss.h>
 
 struct GDT {
@@ -51,6 +59,11 @@ __attribute__((section(".text.start"))) void kernel_entry(struct GDT* gdt)
                      "or  $(3 << 9), %ax\n\t"
                      "mov %eax, %cr4\n\t");
 
+    // make read only pages read only for ring 0 as well, apps run in ring 0
+    __asm__ volatile("mov %cr0, %eax\n\t"
+                     "or  $(1 << 16), %eax\n\t"
+                     "mov %eax, %cr0\n\t");
+
     // interrupt init
     struct IDTPointer idt_pointer;
     idt_pointer.limit = 0xffff;
@@ -144,6 +157,7 @@ __attribute__((section(".text.start"))) void kernel_entry(struct GDT* gdt)
     idt_entries[47] = make_idt_entry((uint32_t*)irq7_15_spurious, 0x8, 0xE);
 
     idt_entries[0x40] = make_idt_entry((uint32_t*)syscall, 0x8, 0xE);
+    init_sysenter(tss.esp0);
 
     // enable the pit timer for 10ms
     uint16_t divisor = TIMER_DIVISOR;
@@ -178,6 +192,9 @@ void main()
 
     vfs_set_driver(get_fs_driver_operations());
 
+    // scratch files stay in memory instead of going to the disk
+    vfs_mount("/tmp", get_tmpfs_driver_operations());
+
     vfs_create_device_file("/dev/tty", get_tty_file_operations(), VFS_CHARACTER_DEVICE);
 
     set_print_output("/dev/tty");
@@ -204,8 +221,18 @@ void main()
 
     set_input_kdb_dev("/dev/kdb");
 
+    vfs_create_device_file("/sys/proc", get_proc_file_operations(), VFS_CHARACTER_DEVICE);
+#ifdef SYSCALL_STATS
+    vfs_create_device_file("/sys/syscalls", get_syscalls_file_operations(), VFS_CHARACTER_DEVICE);
+#endif
+
     init_pager();
 
+    if (init_process_table() != 0) {
+        printf("Unable to create the process table\n");
+        return;
+    }
+
     kernel_table = create_new_table();
 
     while (new_page(PAGER_ERROR, &kernel_table->pde, PAGE_GLOBAL) < (void*)0x400000 - PAGE_SIZE)
@@ -215,43 +242,32 @@ void main()
 
     // testing
 
+    // main becomes the idle process of the bootstrap processor once it enables interrupts
     uint32_t stack0 = (uint32_t)new_page(PAGER_ERROR, &kernel_table->pde, 0);
-    struct process* p0 = create_process("dummy", PROCESS_RUNNING, (uint32_t)NULL, stack0 + PAGE_SIZE - 16, stack0 + PAGE_SIZE - 16, kernel_table, NULL, NULL, NULL);
-    set_current_process(p0->id);
+    create_idle_process("idle0", stack0 + PAGE_SIZE - 16, kernel_table, 0);
 
-    PageTable* app = soft_copy_table((PageTable*)kernel_table, 1);
+    clock_init();
 
-    load_page_table(&app->pde);
+    smp_init();
 
-    while (new_page(PAGER_ERROR, &app->pde, PAGE_GLOBAL) < (void*)0x1000000 - PAGE_SIZE)
-        ;
-    uint32_t app_stack = (uint32_t)new_page(PAGER_ERROR, &app->pde, 0);
+    timer_start();
 
-    VFSFile* file = vfs_open_file("/apps/new_test.bin", VFS_READ);
+    VFSFile* tty = vfs_open_file("/dev/tty", VFS_READ | VFS_WRITE);
+    char* shell_argv[] = { "/apps/new_test.bin", NULL };
 
-    if (file == NULL) {
-        printf("Unable to open file\n");
-        return;
+    spin_lock(&kernel_lock);
+    // without the thread the disk drivers finish async requests before submitting returns
+    if (io_queue_init() != 0) {
+        printf("Unable to start the io queue\n");
     }
+    struct process* shell = spawn_process(shell_argv[0], shell_argv, tty, tty, tty);
+    spin_unlock(&kernel_lock);
 
-    uint8_t* buf = (uint8_t*)(0x400000);
-    vfs_seek(file, 4, VFS_BEG);
-    while (vfs_read(file, buf, 1024)) {
-        buf += 1024;
+    if (shell == NULL) {
+        printf("Unable to start %s\n", shell_argv[0]);
+        return;
     }
 
-    uint32_t entry_point;
-    vfs_seek(file, 0, VFS_BEG);
-    vfs_read(file, &entry_point, 4);
-
-    vfs_close_file(file);
-
-    VFSFile* tty = vfs_open_file("/dev/tty", VFS_READ | VFS_WRITE);
-
-    create_process("new_test", PROCESS_RUNNING, entry_point, app_stack + PAGE_SIZE - 16, app_stack + PAGE_SIZE - 16, app, tty, tty, tty);
-
-    load_page_table(&kernel_table->pde);
-
     // void (*entry_function)() = (void*)entry_point;
     // entry_function();
 
@@ -266,9 +282,6 @@ void main()
     // }
 
     __asm__ volatile("sti"); // reenable maskable interrupts
-    __asm__ volatile("cli");
-    remove_process(p0->id);
-    __asm__ volatile("sti");
     while (1)
-        ;
+        __asm__ volatile("hlt");
 }
@@ -3,12 +3,17 @@
 #include <heap.h>
 #include <memutils.h>
 #include <print.h>
+#include <spinlock.h>
 #include <stdint.h>
 
 void* page_tables_base = (void*)0x300000;
 void* page_tables_limit = (void*)0x400000 - 1;
 void* page_tables_end = (void*)0x300000;
 
+// the free page list and the table area are shared by every cpu
+spinlock_t pager_lock = SPINLOCK_INIT;
+spinlock_t page_tables_lock = SPINLOCK_INIT;
+
 uintptr_t virt_to_phys(uintptr_t virtual_address, PDETable* table)
 {
     uint32_t physical_index = virtual_address & 0xfff;
@@ -113,14 +118,18 @@ void pager_fill(void* start, void* end)
 
 void* alloc_table()
 {
+    uint32_t eflags = spin_lock_irqsave(&page_tables_lock);
     page_tables_end += sizeof(PageTable);
-    return page_tables_end - sizeof(PageTable);
+    void* table = page_tables_end - sizeof(PageTable);
+    spin_unlock_irqrestore(&page_tables_lock, eflags);
+    return table;
 }
 
 void free_pte_table(PTETable* table)
 {
     for (int i = 0; i < TABLE_ENTRIES_LENGTH; i++) {
-        if (table->entries[i].present) {
+        // the kernel pages shared by every table and pages shared between processes have other owners
+        if (table->entries[i].present && !(*(uint32_t*)&table->entries[i] & (PAGE_GLOBAL | PAGE_SHARED))) {
             void* page = (void*)(table->entries[i].physical_page_address << 12);
             pager_fill(page, page + PAGE_SIZE - 1);
         }
@@ -131,12 +140,14 @@ void free_pte_table(PTETable* table)
 
 void free_pde_table(PDETable* table)
 {
+    uint32_t eflags = spin_lock_irqsave(&pager_lock);
     for (int i = 0; i < TABLE_ENTRIES_LENGTH; i++) {
         if (table->entries[i].present) {
             void* page_table = (void*)(table->entries[i].page_table_address << 12);
             free_pte_table(page_table);
         }
     }
+    spin_unlock_irqrestore(&pager_lock, eflags);
     printf("Add a way to actually free the tables\n"); // TODO:
     return;
 }
@@ -154,7 +165,7 @@ uint32_t get_free_page_index(PageTable* table)
         PTETable* sub_table = (void*)(table->pde.entries[i].page_table_address << 12);
 
         for (uint32_t j = 0; j < TABLE_ENTRIES_LENGTH; j++) {
-            if (!sub_table->entries[j].present) {
+            if (!sub_table->entries[j].present && !(*(uint32_t*)&sub_table->entries[j] & PAGE_LAZY)) {
                 return j + i * TABLE_ENTRIES_LENGTH;
             }
         }
@@ -174,6 +185,13 @@ void load_page_table(PDETable* pde_table)
         : "eax");
 }
 
+PDETable* get_loaded_page_table()
+{
+    uint32_t cr3;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(cr3));
+    return (PDETable*)(cr3 & ~0xfff);
+}
+
 void init_pager()
 {
     first_pager_block = malloc(sizeof(struct FreeMemoryBlock));
@@ -200,6 +218,7 @@ PageTable* create_new_table()
 
 void* new_page(void* physical_address, PDETable* pde_table, uint32_t flags)
 {
+    uint32_t eflags = spin_lock_irqsave(&pager_lock);
     if (physical_address != PAGER_ERROR) {
         physical_address = (void*)((uint32_t)(physical_address + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1));
         struct FreeMemoryBlock* entry = first_pager_block;
@@ -239,6 +258,7 @@ void* new_page(void* physical_address, PDETable* pde_table, uint32_t flags)
     pte_entry->write_through = 1;
     *(uint32_t*)pte_entry |= flags;
 
+    spin_unlock_irqrestore(&pager_lock, eflags);
     return (void*)((pde_index << 22) | (pte_index << 12));
 }
 
@@ -259,8 +279,141 @@ void free_page(void* virtual_address, PDETable* pde_table)
         return;
     }
 
+    uint32_t eflags = spin_lock_irqsave(&pager_lock);
     pager_fill((void*)virt_to_phys((uintptr_t)virtual_address, pde_table), (void*)virt_to_phys((uintptr_t)virtual_address, pde_table) + PAGE_SIZE - 1);
     pte_table->entries[pte_index].present = 0;
+    spin_unlock_irqrestore(&pager_lock, eflags);
+}
+
+// entry of the address in the table, creates the last level table if it's missing
+static PTEEntry* get_pte_entry(void* virtual_address, PDETable* pde_table, uint32_t flags)
+{
+    uint32_t pte_index = ((uintptr_t)virtual_address >> 12) & 0x3ff;
+    uint32_t pde_index = ((uintptr_t)virtual_address >> 22) & 0x3ff;
+
+    PDEEntry* pde_entry = &pde_table->entries[pde_index];
+    if (!pde_entry->present) {
+        PTETable* pte_table = (PTETable*)create_new_table();
+        if (pte_table == PAGER_ERROR) {
+            printf("Failed to malloc aligned pte table in map page\n");
+            exit_kernel();
+        }
+
+        pde_entry->present = 1;
+        pde_entry->writeable = 1;
+        pde_entry->write_through = 1;
+        *(uint32_t*)pde_entry |= flags & ~PAGE_LAZY;
+        pde_entry->page_table_address = (uint32_t)pte_table >> 12;
+    }
+
+    PTETable* pte_table = (PTETable*)(pde_entry->page_table_address << 12);
+    return &pte_table->entries[pte_index];
+}
+
+void map_page(void* physical_address, void* virtual_address, PDETable* pde_table, uint32_t flags)
+{
+    PTEEntry* pte_entry = get_pte_entry(virtual_address, pde_table, flags);
+
+    *(uint32_t*)pte_entry = flags | PAGE_PRESENT;
+    pte_entry->physical_page_address = (uint32_t)physical_address >> 12;
+
+    __asm__ volatile("invlpg (%0)" : : "r"(virtual_address) : "memory");
+}
+
+void unmap_page(void* virtual_address, PDETable* pde_table)
+{
+    uint32_t pte_index = ((uintptr_t)virtual_address >> 12) & 0x3ff;
+    uint32_t pde_index = ((uintptr_t)virtual_address >> 22) & 0x3ff;
+
+    PDEEntry* pde_entry = &pde_table->entries[pde_index];
+    if (!pde_entry->present) {
+        return;
+    }
+    PTETable* pte_table = (PTETable*)(pde_entry->page_table_address << 12);
+    *(uint32_t*)&pte_table->entries[pte_index] = 0;
+
+    __asm__ volatile("invlpg (%0)" : : "r"(virtual_address) : "memory");
+}
+
+void map_lazy_page(void* virtual_address, PDETable* pde_table, uint32_t flags)
+{
+    PTEEntry* pte_entry = get_pte_entry(virtual_address, pde_table, flags);
+    *(uint32_t*)pte_entry = (flags & ~PAGE_PRESENT) | PAGE_LAZY;
+    __asm__ volatile("invlpg (%0)" : : "r"(virtual_address) : "memory");
+}
+
+// threads of a process can fault on the same page at once
+spinlock_t lazy_page_lock = SPINLOCK_INIT;
+
+uint8_t fault_lazy_page(void* virtual_address)
+{
+    PDETable* pde_table = get_loaded_page_table();
+    virtual_address = (void*)((uintptr_t)virtual_address & ~(PAGE_SIZE - 1));
+    uint32_t pte_index = ((uintptr_t)virtual_address >> 12) & 0x3ff;
+    uint32_t pde_index = ((uintptr_t)virtual_address >> 22) & 0x3ff;
+    if (!pde_table->entries[pde_index].present) {
+        return 1;
+    }
+    PTETable* pte_table = (PTETable*)(pde_table->entries[pde_index].page_table_address << 12);
+    uint32_t* entry = (uint32_t*)&pte_table->entries[pte_index];
+
+    uint32_t eflags = spin_lock_irqsave(&lazy_page_lock);
+    if (*entry & PAGE_PRESENT) {
+        // another cpu got there first
+        spin_unlock_irqrestore(&lazy_page_lock, eflags);
+        return 0;
+    }
+    if (!(*entry & PAGE_LAZY)) {
+        spin_unlock_irqrestore(&lazy_page_lock, eflags);
+        return 1;
+    }
+    void* physical_address = alloc_page();
+    if (physical_address == PAGER_ERROR) {
+        spin_unlock_irqrestore(&lazy_page_lock, eflags);
+        return 1;
+    }
+    uint32_t flags = *entry & ~PAGE_LAZY & 0xfff;
+    // written through a writable mapping first, read only pages get their flags afterwards
+    map_page(physical_address, virtual_address, pde_table, flags | PAGE_WRITEABLE);
+    memset(virtual_address, 0, PAGE_SIZE);
+    map_page(physical_address, virtual_address, pde_table, flags);
+    spin_unlock_irqrestore(&lazy_page_lock, eflags);
+    return 0;
+}
+
+void* alloc_page()
+{
+    uint32_t eflags = spin_lock_irqsave(&pager_lock);
+    struct FreeMemoryBlock* entry = first_pager_block;
+    if (entry == NULL) {
+        spin_unlock_irqrestore(&pager_lock, eflags);
+        return PAGER_ERROR;
+    }
+    void* physical_address = entry->start;
+    pager_remove(entry, physical_address, physical_address + PAGE_SIZE - 1);
+    spin_unlock_irqrestore(&pager_lock, eflags);
+    return physical_address;
+}
+
+void free_physical_page(void* physical_address)
+{
+    uint32_t eflags = spin_lock_irqsave(&pager_lock);
+    pager_fill(physical_address, physical_address + PAGE_SIZE - 1);
+    spin_unlock_irqrestore(&pager_lock, eflags);
+}
+
+void* map_free_address(void* physical_address, PDETable* pde_table, uint32_t flags)
+{
+    uint32_t eflags = spin_lock_irqsave(&pager_lock);
+    uint32_t index = get_free_page_index((PageTable*)pde_table);
+    if (index == (uint32_t)PAGER_ERROR) {
+        spin_unlock_irqrestore(&pager_lock, eflags);
+        return PAGER_ERROR;
+    }
+    void* virtual_address = (void*)(index << 12);
+    map_page(physical_address, virtual_address, pde_table, flags);
+    spin_unlock_irqrestore(&pager_lock, eflags);
+    return virtual_address;
 }
 
 PageTable* soft_copy_table(PageTable* table, uint16_t number_of_entries)
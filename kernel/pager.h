@@ -56,6 +56,8 @@ enum {
     PAGE_DIRTY = 1 << 6,
     PAGE_PA = 1 << 7,
     PAGE_GLOBAL = 1 << 8,
+    PAGE_LAZY = 1 << 9, // software bit of an entry that isn't present yet, see map_lazy_page
+    PAGE_SHARED = 1 << 10, // software bit of a page owned by someone else, free_pde_table leaves it to the owner
 };
 
 #define PAGER_ERROR (void*)-1
@@ -66,6 +68,8 @@ extern PageTable* kernel_table;
 void init_pager();
 
 void load_page_table(PDETable* pde_table);
+// table the calling cpu has loaded
+PDETable* get_loaded_page_table();
 
 PageTable* create_new_table();
 
@@ -77,6 +81,28 @@ uintptr_t virt_to_phys(uintptr_t virtual_address, PDETable* table);
 void* new_page(void* physical_address, PDETable* pde_table, uint32_t flags);
 void free_page(void* virtual_address, PDETable* pde_table);
 
+// maps the physical page at the given virtual address without reserving it in the pager
+// used for memory mapped devices and pages owned by someone else
+void map_page(void* physical_address, void* virtual_address, PDETable* pde_table, uint32_t flags);
+
+// removes the mapping without giving the physical page back to the pager
+void unmap_page(void* virtual_address, PDETable* pde_table);
+
+// reserves the address for a zeroed page that is only allocated once it's first accessed
+// the entry keeps the flags and stays not present until then, the address must not be used as stack
+void map_lazy_page(void* virtual_address, PDETable* pde_table, uint32_t flags);
+// called on a page fault at virtual_address in the loaded table, maps the zeroed page if the address was reserved with map_lazy_page
+// returns 0 if the access can be retried
+uint8_t fault_lazy_page(void* virtual_address);
+
+// takes a free physical page from the pager without mapping it, returns PAGER_ERROR if there is none left
+void* alloc_page();
+// gives a page taken with alloc_page back to the pager
+void free_physical_page(void* physical_address);
+// maps the physical page at the first free address of the table without reserving it in the pager
+// returns the virtual address or PAGER_ERROR if the table is full
+void* map_free_address(void* physical_address, PDETable* pde_table, uint32_t flags);
+
 PageTable* soft_copy_table(PageTable* table, uint16_t number_of_entries);
 
 void free_pde_table(PDETable* table);
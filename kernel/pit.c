@@ -0,0 +1,28 @@
+#include "pit.h"
+#include <inboutb.h>
+#include <stdint.h>
+
+// https://wiki.osdev.org/Programmable_Interval_Timer
+void pit_wait_us(uint32_t microseconds)
+{
+    uint32_t count = (PIT_FREQUENCY / 1000) * microseconds / 1000;
+    if (count > 0xffff) {
+        count = 0xffff;
+    }
+
+    // gate channel 2 on and keep the speaker off
+    uint8_t control = inb(0x61) & ~0x3;
+    outb(0x61, control);
+
+    outb(0x43, 0xB0); // channel 2, LSB then MSB, mode 0 (interrupt on terminal count)
+    outb(0x42, (uint8_t)(count & 0xFF));
+    outb(0x42, (uint8_t)((count >> 8) & 0xFF));
+
+    // rising edge on the gate starts the count
+    outb(0x61, control | 0x1);
+
+    while (!(inb(0x61) & 0x20))
+        ;
+
+    outb(0x61, control);
+}
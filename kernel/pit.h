@@ -1,7 +1,13 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #define PIT_FREQUENCY 1193182
 #define TIMER_HZ 100 // 100 Hz (10ms tick)
 #define TIMER_DIVISOR (PIT_FREQUENCY / TIMER_HZ)
 
+// busy waits using pit channel 2, so it works with interrupts disabled
+// the longest wait is 54ms
+void pit_wait_us(uint32_t microseconds);
+
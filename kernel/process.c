@@ -1,66 +1,175 @@
 #include "x86_64_structures.h"
+#include <async_io.h>
+#include <clock.h>
 #include <filesystem/virtual-filesystem.h>
+#include <hashmap/hashmap.h>
 #include <heap.h>
+#include <image_cache.h>
+#include <info_page.h>
 #include <memutils.h>
 #include <pager.h>
 #include <print.h>
 #include <process.h>
+#include <smp/smp.h>
+#include <spinlock.h>
+#include <syscall_stats.h>
 #include <stdint.h>
+#include <timer.h>
+#include <tsc.h>
 
 struct process_entry {
     struct process process;
+    // ring of the run queue the process is scheduled on
     struct process_entry* next;
     struct process_entry* prev;
+    // list of every process, used for lookups
+    struct process_entry* list_next;
+    struct process_entry* list_prev;
+    struct run_queue* queue; // NULL for idle processes and zombies
+    uint32_t number_of_threads; // live threads other than the main one, only counted on the main thread
 };
 
+// every cpu schedules from its own queue and steals from the others when it runs dry
+struct run_queue {
+    struct process_entry* first;
+    struct process_entry* current;
+    struct process_entry* previous; // its stack may still be in use until the next switch on this cpu
+    struct process_entry* idle;
+    uint32_t length;
+    uint64_t quantum_end; // monotonic time when the current process has to give up the cpu
+#ifdef TICKLESS
+    uint64_t deadline; // monotonic time the one-shot timer fires at
+#endif
+    spinlock_t lock;
+};
+
+struct run_queue run_queues[MAX_CPUS];
+
+// time slice of each priority, higher priorities run longer before being preempted
+uint32_t priority_quantum_ms[PROCESS_PRIORITY_LEVELS] = { 5, 10, 20, 50 };
+
+// the process list, the pid table and the pid bitmap are protected by kernel_lock
 struct process_entry* first_process = NULL;
-uint32_t free_pid = 0;
 uint32_t number_of_processes = 0;
 
-struct process_entry* current_process = NULL;
+// pid -> process entry, keyed by the id stored in the entry itself
+struct hashmap_s process_table;
+
+// pids are recycled, the search continues after the last handed out pid
+// so a freed pid isn't reused right away by the next process
+uint32_t used_pids[MAX_PROCESS_ID / 32] = { 0 };
+uint32_t next_pid = 0;
+
+int init_process_table()
+{
+    return hashmap_create(64, &process_table);
+}
 
 uint32_t get_free_pid()
 {
-    uint32_t pid = free_pid;
-    free_pid++;
-    return pid;
+    for (uint32_t i = 0; i < MAX_PROCESS_ID; i++) {
+        uint32_t pid = (next_pid + i) % MAX_PROCESS_ID;
+        if (!(used_pids[pid / 32] & (1 << (pid % 32)))) {
+            used_pids[pid / 32] |= 1 << (pid % 32);
+            next_pid = (pid + 1) % MAX_PROCESS_ID;
+            return pid;
+        }
+    }
+    return PROCESS_INVALID_ID;
 }
 
-struct process* create_process(char* name, uint8_t start_state, uint32_t entry_point, uint32_t stack_base_current_table, uint32_t stack_base_apps_table,
-    PageTable* table, VFSFile* stdout, VFSFile* stdin, VFSFile* stderr)
+void release_pid(uint32_t pid)
 {
-    if (strlen(name) > 64 - 1 || strlen(name) == 0) {
-        printf("Invalid name length of %d for process\n", strlen(name));
-        return NULL;
+    used_pids[pid / 32] &= ~(1 << (pid % 32));
+}
+
+struct process_entry* find_process_entry(uint32_t id)
+{
+    return hashmap_get(&process_table, &id, sizeof(uint32_t));
+}
+
+// queue lock must be held
+void run_queue_link(struct run_queue* queue, struct process_entry* entry)
+{
+    if (queue->first == NULL) {
+        queue->first = entry;
+        entry->next = entry;
+        entry->prev = entry;
+    } else {
+        entry->next = queue->first;
+        entry->prev = queue->first->prev;
+        queue->first->prev->next = entry;
+        queue->first->prev = entry;
     }
+    entry->queue = queue;
+    queue->length++;
+}
 
-    struct process_entry* entry = NULL;
-    struct process_entry* prev = NULL;
-    struct process_entry* next = NULL;
-    if (first_process == NULL) {
-        first_process = malloc(sizeof(struct process_entry));
-        if (first_process == NULL) {
-            printf("Failed to malloc space for new process\n");
-            return NULL;
-        }
-        entry = first_process;
-        prev = entry;
-        next = entry;
+// queue lock must be held
+void run_queue_unlink(struct run_queue* queue, struct process_entry* entry)
+{
+    if (entry->next == entry) {
+        queue->first = NULL;
     } else {
+        entry->prev->next = entry->next;
+        entry->next->prev = entry->prev;
+        if (queue->first == entry) {
+            queue->first = entry->next;
+        }
+    }
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->queue = NULL;
+    queue->length--;
+}
 
-        entry = malloc(sizeof(struct process_entry));
-        if (entry == NULL) {
-            printf("Failed to malloc space for new process\n");
-            return NULL;
+// puts the process on the cpu with the least work
+void enqueue_process(struct process_entry* entry)
+{
+    struct run_queue* queue = &run_queues[0];
+    for (uint32_t i = 1; i < number_of_cpus; i++) {
+        if (run_queues[i].length < queue->length) {
+            queue = &run_queues[i];
         }
+    }
+    uint32_t eflags = spin_lock_irqsave(&queue->lock);
+    run_queue_link(queue, entry);
+    spin_unlock_irqrestore(&queue->lock, eflags);
+
+    // the cpu could be idle until its next deadline
+    smp_reschedule(queue - run_queues);
+}
+
+// builds the process entry and its initial register frame
+// ecx and edx are loaded into the registers of the same name when the process first runs
+struct process* create_process_entry(char* name, uint8_t start_state, uint32_t entry_point, uint32_t stack_base_current_table, uint32_t stack_base_apps_table,
+    PageTable* table, VFSFile* stdout, VFSFile* stdin, VFSFile* stderr, uint32_t ecx, uint32_t edx)
+{
+    if (strlen(name) > 64 - 1 || strlen(name) == 0) {
+        printf("Invalid name length of %d for process\n", strlen(name));
+        return NULL;
+    }
 
-        next = first_process;
-        prev = first_process->prev;
+    uint32_t id = get_free_pid();
+    if (id == PROCESS_INVALID_ID) {
+        printf("Out of process ids\n");
+        return NULL;
     }
 
+    struct process_entry* entry = malloc(sizeof(struct process_entry));
+    if (entry == NULL) {
+        printf("Failed to malloc space for new process\n");
+        release_pid(id);
+        return NULL;
+    }
     memset(entry, 0, sizeof(struct process_entry));
-    entry->prev = prev;
-    entry->next = next;
+    entry->process.id = id;
+    if (hashmap_put(&process_table, &entry->process.id, sizeof(uint32_t), entry) != 0) {
+        printf("Failed to add process %d to the process table\n", id);
+        release_pid(id);
+        free(entry);
+        return NULL;
+    }
 
     uintptr_t real_esp = stack_base_apps_table - sizeof(struct registers) - sizeof(struct interrupt_frame);
     real_esp &= ~0xF; // align to 16 bytes
@@ -69,17 +178,22 @@ struct process* create_process(char* name, uint8_t start_state, uint32_t entry_p
 
     struct process* process = &entry->process;
     process->esp = real_esp;
-    process->id = get_free_pid();
+    process->group_id = process->id;
     process->page_table = table;
     process->stdout = stdout;
     process->stdin = stdin;
     process->stderr = stderr;
     process->state = start_state;
+    process->priority = PROCESS_PRIORITY_NORMAL;
+    process->parent_id = PROCESS_INVALID_ID;
+    process->account_start = read_tsc();
     memcpy(process->name, name, strlen(name));
 
     struct registers regs = { 0 };
     regs.esp = real_esp + sizeof(struct interrupt_frame);
     regs.ebp = stack_base_apps_table ;
+    regs.ecx = ecx;
+    regs.edx = edx;
 
     struct interrupt_frame frame = { 0 };
     frame.eip = entry_point;
@@ -118,58 +232,217 @@ struct process* create_process(char* name, uint8_t start_state, uint32_t entry_p
     memcpy((void*)cur_esp + sizeof(struct registers), &frame, sizeof(struct interrupt_frame));
     memcpy((void*)cur_esp, &regs, sizeof(struct registers));
 
+    entry->list_next = first_process;
+    if (first_process != NULL) {
+        first_process->list_prev = entry;
+    }
+    first_process = entry;
     number_of_processes++;
-    next->prev = entry;
-    prev->next = entry;
     return &entry->process;
 }
 
-struct process* get_process_by_id(uint32_t id)
+struct process* create_process(char* name, uint8_t start_state, uint32_t entry_point, uint32_t stack_base_current_table, uint32_t stack_base_apps_table,
+    PageTable* table, VFSFile* stdout, VFSFile* stdin, VFSFile* stderr, uint32_t argument0, uint32_t argument1)
 {
-    struct process_entry* entry = first_process;
-    while (entry->process.id != id) {
-        entry = entry->next;
-        if (entry == NULL) {
-            printf("Process with id %d does not exist and can not be retrieved\n", id);
-            return NULL;
+    struct process* process = create_process_entry(name, start_state, entry_point, stack_base_current_table, stack_base_apps_table, table, stdout, stdin, stderr, argument0, argument1);
+    if (process == NULL) {
+        return NULL;
+    }
+    // the process making the call is the parent, the idle process when the kernel starts one
+    if (info_page_create(process, get_current_process()) != 0) {
+        // the files stay with the caller
+        process->stdout = NULL;
+        process->stdin = NULL;
+        process->stderr = NULL;
+        remove_process(process->id);
+        return NULL;
+    }
+#ifdef SYSCALL_STATS
+    process->syscall_stats = syscall_stats_create();
+#endif
+    enqueue_process((struct process_entry*)process);
+    return process;
+}
+
+struct process* create_idle_process(char* name, uint32_t stack_base, PageTable* table, uint32_t cpu_index)
+{
+    struct process* process = create_process_entry(name, PROCESS_RUNNING, (uint32_t)NULL, stack_base, stack_base, table, NULL, NULL, NULL, 0, 0);
+    if (process == NULL) {
+        return NULL;
+    }
+    struct run_queue* queue = &run_queues[cpu_index];
+    uint32_t eflags = spin_lock_irqsave(&queue->lock);
+    queue->idle = (struct process_entry*)process;
+    queue->current = queue->idle;
+    spin_unlock_irqrestore(&queue->lock, eflags);
+    return process;
+}
+
+struct process* create_thread(struct process* parent, uint32_t entry_point, uint32_t argument0, uint32_t argument1)
+{
+    void* stack = new_page(PAGER_ERROR, &parent->page_table->pde, 0);
+    if (stack == PAGER_ERROR) {
+        printf("Failed to allocate stack for thread of process %d\n", parent->id);
+        return NULL;
+    }
+    uint32_t stack_base = (uint32_t)stack + PAGE_SIZE - 16;
+
+    // the stack page is mapped in the parent's table which is the current table, so both addresses are the same
+    struct process* thread = create_process_entry(parent->name, PROCESS_RUNNING, entry_point, stack_base, stack_base,
+        parent->page_table, parent->stdout, parent->stdin, parent->stderr, argument0, argument1);
+    if (thread == NULL) {
+        free_page(stack, &parent->page_table->pde);
+        return NULL;
+    }
+    thread->group_id = parent->group_id;
+    thread->thread_stack = (uintptr_t)stack;
+    thread->info_page = parent->info_page;
+#ifdef SYSCALL_STATS
+    thread->syscall_stats = parent->syscall_stats;
+#endif
+    ((struct process_entry*)get_process_by_id(parent->group_id))->number_of_threads++;
+    enqueue_process((struct process_entry*)thread);
+    return thread;
+}
+
+// a process running on another cpu would keep running user code until that cpu's next deadline
+static void preempt_if_running(struct process_entry* entry)
+{
+    for (uint32_t i = 0; i < number_of_cpus; i++) {
+        if (run_queues[i].current == entry) {
+            smp_reschedule(i);
         }
     }
-    return &entry->process;
 }
 
-void remove_process(uint32_t id)
+void terminate_process(struct process* process, uint32_t exit_code)
 {
+    process->exit_code = exit_code;
+    process->state = PROCESS_TERMINATED;
+    preempt_if_running((struct process_entry*)process);
+
+    if (process->group_id != process->id) {
+        return;
+    }
+    info_page_child_changed(process);
+
+    // the page table is freed together with the main thread, so the thread stacks go with it
     struct process_entry* entry = first_process;
-    while (entry->process.id != id) {
-        entry = entry->next;
-        if (entry == first_process) {
-            printf("Process with id %d does not exist and can not be removed\n", id);
-            return;
+    while (entry != NULL) {
+        struct process* thread = &entry->process;
+        entry = entry->list_next;
+        if (thread->group_id != process->id || thread == process) {
+            continue;
         }
+        if (thread->state == PROCESS_ZOMBIE) {
+            // nobody is left to join it
+            remove_process(thread->id);
+            continue;
+        }
+        thread->exit_code = exit_code;
+        thread->state = PROCESS_TERMINATED;
+        thread->thread_stack = 0;
+        thread->detached = 1;
+        preempt_if_running((struct process_entry*)thread);
     }
+}
 
-    struct process* process = &entry->process;
+void reap_process(struct process* process)
+{
+    if (process->group_id == process->id) {
+        info_page_destroy(process);
+        async_io_release(process);
+#ifdef SYSCALL_STATS
+        free(process->syscall_stats);
+#endif
+        free_pde_table(&process->page_table->pde);
+        if (process->image != NULL) {
+            image_release(process->image);
+        }
+        remove_process(process->id);
+        return;
+    }
 
-    if (process->stdout != NULL) {
-        vfs_close_file(process->stdout);
+    if (process->thread_stack != 0) {
+        free_page((void*)process->thread_stack, &process->page_table->pde);
+        process->thread_stack = 0;
     }
-    if (process->stdin != NULL) {
-        vfs_close_file(process->stdin);
+
+    if (process->detached) {
+        remove_process(process->id);
+        return;
+    }
+    process->state = PROCESS_ZOMBIE;
+}
+
+struct process* find_process(uint32_t id)
+{
+    struct process_entry* entry = find_process_entry(id);
+    return entry == NULL ? NULL : &entry->process;
+}
+
+struct process* get_process_by_id(uint32_t id)
+{
+    struct process_entry* entry = find_process_entry(id);
+    if (entry == NULL) {
+        printf("Process with id %d does not exist and can not be retrieved\n", id);
+        return NULL;
     }
-    if (process->stderr != NULL) {
-        vfs_close_file(process->stderr);
+    return &entry->process;
+}
+
+void remove_process(uint32_t id)
+{
+    struct process_entry* entry = find_process_entry(id);
+    if (entry == NULL) {
+        printf("Process with id %d does not exist and can not be removed\n", id);
+        return;
     }
 
-    struct process_entry* prev = entry->prev;
-    struct process_entry* next = entry->next;
+    struct process* process = &entry->process;
+
+    // threads borrow the std files of the main thread
+    if (process->group_id == process->id) {
+        if (process->stdout != NULL) {
+            vfs_close_file(process->stdout);
+        }
+        if (process->stdin != NULL) {
+            vfs_close_file(process->stdin);
+        }
+        if (process->stderr != NULL) {
+            vfs_close_file(process->stderr);
+        }
+    } else {
+        struct process* leader = get_process_by_id(process->group_id);
+        if (leader != NULL) {
+            ((struct process_entry*)leader)->number_of_threads--;
+        }
+    }
 
-    prev->next = next;
-    next->prev = prev;
+    struct run_queue* queue = entry->queue;
+    if (queue != NULL) {
+        uint32_t eflags = spin_lock_irqsave(&queue->lock);
+        run_queue_unlink(queue, entry);
+        spin_unlock_irqrestore(&queue->lock, eflags);
+    }
+    for (uint32_t i = 0; i < number_of_cpus; i++) {
+        if (run_queues[i].idle == entry) {
+            run_queues[i].idle = NULL;
+            run_queues[i].current = NULL;
+        }
+    }
 
-    if (entry == first_process) {
-        first_process = next;
+    if (entry->list_prev != NULL) {
+        entry->list_prev->list_next = entry->list_next;
+    } else {
+        first_process = entry->list_next;
+    }
+    if (entry->list_next != NULL) {
+        entry->list_next->list_prev = entry->list_prev;
     }
 
+    hashmap_remove(&process_table, &entry->process.id, sizeof(uint32_t));
+    release_pid(id);
     free(entry);
 
     number_of_processes--;
@@ -178,26 +451,294 @@ void remove_process(uint32_t id)
 
 struct process* set_current_process(uint32_t id)
 {
-    struct process_entry* entry = first_process;
-    while (entry->process.id != id) {
+    struct process* process = get_process_by_id(id);
+    if (process == NULL) {
+        printf("Process with id %d does not exist and can not be set to current process\n", id);
+        return NULL;
+    }
+
+    run_queues[get_cpu_index()].current = (struct process_entry*)process;
+
+    return process;
+}
+
+struct process* get_current_process()
+{
+    return &run_queues[get_cpu_index()].current->process;
+}
+
+// the main thread owns the page table so it has to outlive its threads
+uint8_t process_can_be_reaped(struct process_entry* entry)
+{
+    return entry->process.group_id != entry->process.id || entry->number_of_threads == 0;
+}
+
+// takes a runnable process from another cpu, the lock of the local queue must be held
+struct process_entry* steal_process(struct run_queue* local)
+{
+    for (uint32_t i = 0; i < number_of_cpus; i++) {
+        struct run_queue* queue = &run_queues[i];
+        if (queue == local || queue->first == NULL || !spin_trylock(&queue->lock)) {
+            continue;
+        }
+        struct process_entry* entry = queue->first;
+        for (uint32_t j = 0; j < queue->length; j++, entry = entry->next) {
+            if (entry->process.state == PROCESS_RUNNING && entry != queue->current && entry != queue->previous) {
+                run_queue_unlink(queue, entry);
+                spin_unlock(&queue->lock);
+                run_queue_link(local, entry);
+                return entry;
+            }
+        }
+        spin_unlock(&queue->lock);
+    }
+    return NULL;
+}
+
+// adds the time since the last accounting point to the user or kernel time of the process
+void account_time(struct process* process, uint64_t now)
+{
+    if (process->in_system_call) {
+        process->kernel_time += now - process->account_start;
+    } else {
+        process->user_time += now - process->account_start;
+    }
+    process->account_start = now;
+}
+
+void account_system_call_enter(struct process* process)
+{
+    account_time(process, read_tsc());
+    process->in_system_call = 1;
+}
+
+void account_system_call_exit(struct process* process)
+{
+    account_time(process, read_tsc());
+    process->in_system_call = 0;
+}
+
+uint32_t get_number_of_processes()
+{
+    return number_of_processes;
+}
+
+uint32_t get_process_info(struct process_info* buffer, uint32_t max_entries)
+{
+    uint32_t count = 0;
+    for (struct process_entry* entry = first_process; entry != NULL && count < max_entries; entry = entry->list_next) {
+        struct process* process = &entry->process;
+        struct process_info* info = &buffer[count];
+        info->id = process->id;
+        info->group_id = process->group_id;
+        info->state = process->state;
+        memcpy(info->name, process->name, sizeof(info->name));
+        info->cpu = entry->queue != NULL ? (uint32_t)(entry->queue - run_queues) : 0;
+        for (uint32_t i = 0; i < number_of_cpus; i++) {
+            if (run_queues[i].idle == entry) {
+                info->cpu = i;
+            }
+        }
+        info->user_time = process->user_time;
+        info->kernel_time = process->kernel_time;
+        info->context_switches = process->context_switches;
+        info->voluntary_switches = process->voluntary_switches;
+        info->involuntary_switches = process->involuntary_switches;
+        count++;
+    }
+    return count;
+}
+
+#ifdef SYSCALL_STATS
+uint32_t get_syscall_stats(struct syscall_stats_record* buffer, uint32_t max_entries)
+{
+    uint32_t count = syscall_stats_get_records(NULL, PROCESS_INVALID_ID, buffer, max_entries);
+    for (struct process_entry* entry = first_process; entry != NULL; entry = entry->list_next) {
+        struct process* process = &entry->process;
+        if (process->group_id != process->id || process->syscall_stats == NULL) {
+            continue;
+        }
+        if (buffer == NULL) {
+            count += syscall_stats_get_records(process->syscall_stats, process->id, NULL, 0);
+        } else if (count < max_entries) {
+            count += syscall_stats_get_records(process->syscall_stats, process->id, &buffer[count], max_entries - count);
+        }
+    }
+    return count;
+}
+
+uint32_t reset_syscall_stats(uint32_t id)
+{
+    if (id != PROCESS_INVALID_ID) {
+        struct process* process = find_process(id);
+        if (process == NULL || process->syscall_stats == NULL) {
+            return 1;
+        }
+        syscall_stats_reset(process->syscall_stats);
+        return 0;
+    }
+    syscall_stats_reset(NULL);
+    for (struct process_entry* entry = first_process; entry != NULL; entry = entry->list_next) {
+        if (entry->process.group_id == entry->process.id && entry->process.syscall_stats != NULL) {
+            syscall_stats_reset(entry->process.syscall_stats);
+        }
+    }
+    return 0;
+}
+#endif
+
+struct process* schedule(uintptr_t esp)
+{
+    struct run_queue* queue = &run_queues[get_cpu_index()];
+    spin_lock(&queue->lock);
+
+    struct process_entry* current = queue->current;
+    current->process.esp = esp;
+    uint64_t now = read_tsc();
+    uint64_t now_ns = clock_monotonic_ns();
+    account_time(&current->process, now);
+
+    // reaping touches the process list, so it waits for a tick when no system call is running
+    uint8_t can_reap = spin_trylock(&kernel_lock);
+
+    // every entry is visited to wake sleepers and find the earliest deadline, the first runnable one after current is picked
+    struct process_entry* next = NULL;
+    uint32_t runnable = 0;
+    uint64_t earliest_wake = now_ns + TIMER_MAX_DEADLINE_NS;
+    struct process_entry* entry = (current->queue == queue) ? current->next : queue->first;
+    uint32_t length = queue->length;
+    for (uint32_t i = 0; i < length; i++) {
+        struct process_entry* candidate = entry;
         entry = entry->next;
-        if (entry == first_process) {
-            printf("Process with id %d does not exist and can not be set to current process\n", id);
-            return NULL;
+
+        if (candidate->process.state == PROCESS_SLEEPING) {
+            if (now_ns < candidate->process.wake_time) {
+                if (candidate->process.wake_time < earliest_wake) {
+                    earliest_wake = candidate->process.wake_time;
+                }
+                continue;
+            }
+            candidate->process.state = PROCESS_RUNNING;
+        }
+
+        if (candidate->process.state == PROCESS_RUNNING) {
+            runnable++;
+            if (next == NULL) {
+                next = candidate;
+            }
+        } else if (candidate->process.state == PROCESS_TERMINATED) {
+            if (can_reap && candidate != current && process_can_be_reaped(candidate)) {
+                run_queue_unlink(queue, candidate);
+                reap_process(&candidate->process);
+            }
+        }
+    }
+
+    if (can_reap) {
+        spin_unlock(&kernel_lock);
+    }
+
+    // the current process keeps the cpu until its quantum runs out
+    if (current->queue == queue && current->process.state == PROCESS_RUNNING && now_ns < queue->quantum_end) {
+        next = current;
+    }
+    if (next == NULL) {
+        next = steal_process(queue);
+        if (next != NULL) {
+            runnable++;
+        }
+    }
+    if (next == NULL) {
+        next = queue->idle;
+    }
+
+    if (next != current) {
+        // system calls run with interrupts off unless they block
+        if (current->process.state != PROCESS_RUNNING || current->process.in_system_call) {
+            current->process.voluntary_switches++;
+        } else {
+            current->process.involuntary_switches++;
         }
+        next->process.context_switches++;
+        next->process.account_start = now;
+        queue->previous = current;
+    }
+    if (next != current || now_ns >= queue->quantum_end) {
+        queue->quantum_end = now_ns + (uint64_t)priority_quantum_ms[next->process.priority] * 1000000;
+    }
+    queue->current = next;
+    info_page_update_time(&next->process, now_ns);
+
+#ifdef TICKLESS
+    // a process alone on the cpu runs until a sleeper is due
+    uint64_t deadline = earliest_wake;
+    if (runnable > 1 && queue->quantum_end < deadline) {
+        deadline = queue->quantum_end;
     }
+    queue->deadline = deadline;
+    timer_set_deadline(deadline > now_ns ? deadline - now_ns : 0);
+#endif
 
-    current_process = entry;
+    spin_unlock(&queue->lock);
+    return &next->process;
+}
 
-    return &current_process->process;
+void yield_process()
+{
+    // give up the rest of the quantum, then go through the timer vector so the switch looks like any other preemption
+    struct run_queue* queue = &run_queues[get_cpu_index()];
+    uint32_t eflags = spin_lock_irqsave(&queue->lock);
+    queue->quantum_end = 0;
+    spin_unlock_irqrestore(&queue->lock, eflags);
+    __asm__ volatile("int $32" ::: "memory");
 }
 
-struct process* get_current_process()
+void wake_process(struct process* process)
 {
-    return &current_process->process;
+    process->state = PROCESS_RUNNING;
+    // the queue can change under a steal, at worst the wrong cpu is interrupted and the process waits for a tick
+    struct run_queue* queue = ((struct process_entry*)process)->queue;
+    if (queue == NULL) {
+        return;
+    }
+    uint32_t cpu_index = queue - run_queues;
+    if (cpu_index != get_cpu_index()) {
+        smp_reschedule(cpu_index);
+        return;
+    }
+#ifdef TICKLESS
+    // the deadline was set while the process was blocked, it could be a lone process's sleep or a whole idle second away
+    uint32_t eflags = spin_lock_irqsave(&queue->lock);
+    uint64_t now_ns = clock_monotonic_ns();
+    uint64_t deadline = queue->current == queue->idle ? now_ns : queue->quantum_end;
+    if (deadline < queue->deadline) {
+        queue->deadline = deadline;
+        timer_set_deadline(deadline > now_ns ? deadline - now_ns : 0);
+    }
+    spin_unlock_irqrestore(&queue->lock, eflags);
+#endif
+}
+
+void sleep_process(struct process* process, uint64_t nanoseconds)
+{
+    process->wake_time = clock_monotonic_ns() + nanoseconds;
+    process->state = PROCESS_SLEEPING;
 }
-struct process* get_next_process()
+
+int set_process_priority(struct process* process, uint8_t priority)
+{
+    if (priority >= PROCESS_PRIORITY_LEVELS) {
+        return 1;
+    }
+    process->priority = priority;
+    return 0;
+}
+
+int set_priority_quantum(uint8_t priority, uint32_t milliseconds)
 {
-    current_process = current_process->next;
-    return &current_process->process;
+    if (priority >= PROCESS_PRIORITY_LEVELS || milliseconds == 0 || milliseconds > 1000) {
+        return 1;
+    }
+    priority_quantum_ms[priority] = milliseconds;
+    return 0;
 }
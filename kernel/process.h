@@ -5,17 +5,64 @@
 
 #include <filesystem/virtual-filesystem.h>
 #include <pager.h>
-#include <time.h>
 #include <x86_64_structures.h>
 
+struct io_ring;
+struct async_io;
+struct info_page;
+struct syscall_stats;
+struct image;
+struct syscall_stats_record;
+
 struct process {
     uintptr_t esp;
     PageTable* page_table;
     VFSFile *stdout, *stdin, *stderr;
-    struct time wake_time;
+    uint64_t wake_time; // monotonic nanoseconds
     uint8_t state;
     char name[64];
     uint32_t id;
+    uint32_t group_id; // id of the process owning the page table and std files, same as id for the main thread
+    uintptr_t thread_stack; // stack page allocated for a thread, 0 if the stack isn't owned by the process
+    uint32_t exit_code;
+    uint8_t detached; // thread will be removed without being joined
+
+    // cpu accounting, times are in tsc ticks
+    uint64_t user_time;
+    uint64_t kernel_time;
+    uint64_t account_start; // tsc at the start of the period not yet added to the times
+    uint32_t context_switches; // times the process was switched to
+    uint32_t voluntary_switches; // switched out while blocked, sleeping or after exiting
+    uint32_t involuntary_switches; // switched out while it could still run
+    uint8_t in_system_call;
+    uint8_t priority; // picks the length of the time slice
+
+    // set on the main thread, see io_ring.h
+    struct io_ring* io_ring;
+    uint32_t io_ring_poller; // id of the polling thread
+    uint8_t io_ring_busy; // a cpu is running the submissions
+    struct async_io* async_io; // set on the main thread, requests that weren't collected yet, see async_io.h
+
+    struct info_page* info_page; // kernel address of the page, shared with the threads
+    uint32_t parent_id; // process that started this one, PROCESS_INVALID_ID if none
+#ifdef SYSCALL_STATS
+    struct syscall_stats* syscall_stats; // shared with the threads, NULL if there was no memory left
+#endif
+    struct image* image; // program the process was spawned from, its read only pages are shared
+};
+
+// snapshot of a process as exposed through /sys/proc
+struct process_info {
+    uint32_t id;
+    uint32_t group_id;
+    uint8_t state;
+    char name[64];
+    uint32_t cpu;
+    uint64_t user_time;
+    uint64_t kernel_time;
+    uint32_t context_switches;
+    uint32_t voluntary_switches;
+    uint32_t involuntary_switches;
 };
 
 enum {
@@ -23,8 +70,20 @@ enum {
     PROCESS_RUNNING = 1,
     PROCESS_SUSPENDED = 2,
     PROCESS_SLEEPING = 3,
+    PROCESS_ZOMBIE = 4, // terminated thread waiting to be joined
+};
+
+enum {
+    PROCESS_PRIORITY_LOW = 0,
+    PROCESS_PRIORITY_NORMAL = 1,
+    PROCESS_PRIORITY_HIGH = 2,
+    PROCESS_PRIORITY_HIGHEST = 3,
+    PROCESS_PRIORITY_LEVELS = 4,
 };
 
+#define MAX_PROCESS_ID 4096
+#define PROCESS_INVALID_ID ((uint32_t)-1)
+
 struct process_init_data {
     uint8_t initial_state;
     char* name;
@@ -35,12 +94,63 @@ struct process_init_data {
     VFSFile *stdout, *stdin, *stderr;
 };
 
+// sets up the pid table, must be called before the first process is created
+int init_process_table();
+
+// creating, looking up and removing processes expects kernel_lock to be held once other cpus are running
+// the main thread starts with ecx and edx set to the given arguments
 struct process* create_process(char* name, uint8_t start_state, uint32_t entry_point, uint32_t stack_base_current_table, uint32_t stack_base_apps_table,
-    PageTable* table, VFSFile* stdout, VFSFile* stdin, VFSFile* stderr);
+    PageTable* table, VFSFile* stdout, VFSFile* stdin, VFSFile* stderr, uint32_t argument0, uint32_t argument1);
+
+// creates a new thread sharing the page table and std files of the parent
+// the thread starts at entry_point with ecx and edx set to the given arguments
+// must be called while the parent's page table is loaded
+struct process* create_thread(struct process* parent, uint32_t entry_point, uint32_t argument0, uint32_t argument1);
+
+// marks the process as terminated, if it is the main thread all the other threads of the process are terminated too
+void terminate_process(struct process* process, uint32_t exit_code);
+// frees the resources of a terminated process and removes it (or turns a joinable thread into a zombie)
+void reap_process(struct process* process);
 
 struct process* get_process_by_id(uint32_t id);
+// same as get_process_by_id without reporting missing processes
+struct process* find_process(uint32_t id);
 void remove_process(uint32_t id);
 
+// creates the process the cpu falls back to when there is nothing to run, it never joins a run queue
+// the code running on the cpu when the first switch happens becomes the idle process
+struct process* create_idle_process(char* name, uint32_t stack_base, PageTable* table, uint32_t cpu_index);
+
+// fills buffer with up to max_entries processes, returns the number written
+uint32_t get_process_info(struct process_info* buffer, uint32_t max_entries);
+uint32_t get_number_of_processes();
+
+#ifdef SYSCALL_STATS
+// records of the global numbers followed by the ones of every process, buffer NULL only counts them
+uint32_t get_syscall_stats(struct syscall_stats_record* buffer, uint32_t max_entries);
+// id PROCESS_INVALID_ID resets every process and the global numbers, returns 1 if there's no such process
+uint32_t reset_syscall_stats(uint32_t id);
+#endif
+
+// split the cpu time of the current process between user and kernel time
+void account_system_call_enter(struct process* process);
+void account_system_call_exit(struct process* process);
+
+// sets the current process of the calling cpu
 struct process* set_current_process(uint32_t id);
 struct process* get_current_process();
-struct process* get_next_process();
+
+// saves the stack of the current process and picks the next one for the calling cpu, interrupts must be disabled
+// with TICKLESS it also programs the timer for the next deadline
+struct process* schedule(uintptr_t esp);
+
+// switches to the next process right away, the caller continues when it's scheduled again
+void yield_process();
+// makes a sleeping or suspended process runnable and gets its cpu to schedule it soon instead of at its old deadline
+void wake_process(struct process* process);
+// the process stops being scheduled until the time passes, the caller still has to yield
+void sleep_process(struct process* process, uint64_t nanoseconds);
+
+// return 0 on success
+int set_process_priority(struct process* process, uint8_t priority);
+int set_priority_quantum(uint8_t priority, uint32_t milliseconds);
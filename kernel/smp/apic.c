@@ -0,0 +1,135 @@
+#include "apic.h"
+#include <pager.h>
+#include <pit.h>
+#include <stdint.h>
+
+uint8_t apic_active = 0;
+uint32_t lapic_ticks_per_ms = 0;
+
+static inline uint32_t lapic_read(uint32_t reg)
+{
+    return *(volatile uint32_t*)(LAPIC_VIRTUAL_ADDRESS + reg);
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value)
+{
+    *(volatile uint32_t*)(LAPIC_VIRTUAL_ADDRESS + reg) = value;
+}
+
+static inline uint32_t ioapic_read(uint32_t reg)
+{
+    *(volatile uint32_t*)IOAPIC_VIRTUAL_ADDRESS = reg;
+    return *(volatile uint32_t*)(IOAPIC_VIRTUAL_ADDRESS + 0x10);
+}
+
+static inline void ioapic_write(uint32_t reg, uint32_t value)
+{
+    *(volatile uint32_t*)IOAPIC_VIRTUAL_ADDRESS = reg;
+    *(volatile uint32_t*)(IOAPIC_VIRTUAL_ADDRESS + 0x10) = value;
+}
+
+void lapic_init(uintptr_t physical_address)
+{
+    map_page((void*)physical_address, (void*)LAPIC_VIRTUAL_ADDRESS, &kernel_table->pde, PAGE_WRITEABLE | PAGE_DISABLE_CACHING | PAGE_GLOBAL);
+    apic_active = 1;
+}
+
+void lapic_enable()
+{
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_SVR, 0x100 | LAPIC_SPURIOUS_VECTOR);
+}
+
+uint8_t lapic_id()
+{
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+void lapic_eoi()
+{
+    lapic_write(LAPIC_EOI, 0);
+}
+
+void lapic_wait_for_delivery()
+{
+    while (lapic_read(LAPIC_ICR_LOW) & (1 << 12))
+        __asm__ volatile("pause");
+}
+
+void lapic_send_init(uint8_t apic_id)
+{
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, 0x4500); // init, level assert
+    lapic_wait_for_delivery();
+}
+
+void lapic_send_startup(uint8_t apic_id, uint8_t vector_page)
+{
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, 0x4600 | vector_page); // startup, the ap starts at vector_page * 0x1000
+    lapic_wait_for_delivery();
+}
+
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector)
+{
+    lapic_write(LAPIC_ICR_HIGH, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, vector); // fixed delivery
+    lapic_wait_for_delivery();
+}
+
+void lapic_timer_calibrate()
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, 0x3); // divide by 16
+    lapic_write(LAPIC_TIMER_LVT, LAPIC_TIMER_MASKED);
+    lapic_write(LAPIC_TIMER_INITIAL, 0xFFFFFFFF);
+    pit_wait_us(10000);
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+    lapic_ticks_per_ms = elapsed / 10;
+}
+
+void lapic_timer_start(uint32_t hz, uint8_t vector)
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, 0x3);
+    lapic_write(LAPIC_TIMER_LVT, LAPIC_TIMER_PERIODIC | vector);
+    lapic_write(LAPIC_TIMER_INITIAL, lapic_ticks_per_ms * 1000 / hz);
+}
+
+void lapic_timer_oneshot(uint64_t nanoseconds, uint8_t vector)
+{
+    // there is no libgcc for 64 bit division, a second fits in 32 bits of nanoseconds
+    if (nanoseconds > 1000000000) {
+        nanoseconds = 1000000000;
+    }
+    uint32_t microseconds = (uint32_t)nanoseconds / 1000;
+    uint32_t count = microseconds / 1000 * lapic_ticks_per_ms + microseconds % 1000 * lapic_ticks_per_ms / 1000;
+    if (count == 0) {
+        count = 1;
+    }
+    lapic_write(LAPIC_TIMER_DIVIDE, 0x3);
+    lapic_write(LAPIC_TIMER_LVT, vector); // one shot
+    lapic_write(LAPIC_TIMER_INITIAL, count);
+}
+
+void ioapic_init(uintptr_t physical_address)
+{
+    map_page((void*)physical_address, (void*)IOAPIC_VIRTUAL_ADDRESS, &kernel_table->pde, PAGE_WRITEABLE | PAGE_DISABLE_CACHING | PAGE_GLOBAL);
+
+    // mask every input until it's routed
+    uint32_t max_entry = (ioapic_read(0x01) >> 16) & 0xFF;
+    for (uint32_t i = 0; i <= max_entry; i++) {
+        ioapic_write(IOAPIC_REDIRECTION_TABLE + i * 2, 1 << 16);
+    }
+}
+
+void ioapic_route(uint8_t pin, uint8_t vector, uint8_t apic_id)
+{
+    // fixed delivery, physical destination, edge triggered, active high
+    ioapic_write(IOAPIC_REDIRECTION_TABLE + pin * 2 + 1, (uint32_t)apic_id << 24);
+    ioapic_write(IOAPIC_REDIRECTION_TABLE + pin * 2, vector);
+}
+
+uint8_t apic_enabled()
+{
+    return apic_active;
+}
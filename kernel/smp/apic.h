@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// local and io apic
+// https://wiki.osdev.org/APIC
+// https://wiki.osdev.org/IOAPIC
+
+// both are mapped into the shared low 4MB so every page table sees them
+#define LAPIC_VIRTUAL_ADDRESS 0x2FF000
+#define IOAPIC_VIRTUAL_ADDRESS 0x2FE000
+
+#define LAPIC_ID 0x20
+#define LAPIC_TPR 0x80
+#define LAPIC_EOI 0xB0
+#define LAPIC_SVR 0xF0
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_TIMER_LVT 0x320
+#define LAPIC_TIMER_INITIAL 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIVIDE 0x3E0
+
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+#define LAPIC_TIMER_PERIODIC (1 << 17)
+#define LAPIC_TIMER_MASKED (1 << 16)
+
+#define IOAPIC_REDIRECTION_TABLE 0x10
+
+void lapic_init(uintptr_t physical_address);
+// enables the local apic of the cpu calling it
+void lapic_enable();
+uint8_t lapic_id();
+void lapic_eoi();
+
+void lapic_send_init(uint8_t apic_id);
+void lapic_send_startup(uint8_t apic_id, uint8_t vector_page);
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector);
+
+// measures the bus frequency against the pit, must be run once before starting the timer
+void lapic_timer_calibrate();
+// starts the periodic timer of the calling cpu on the given vector
+void lapic_timer_start(uint32_t hz, uint8_t vector);
+// fires the timer of the calling cpu once after the given time
+void lapic_timer_oneshot(uint64_t nanoseconds, uint8_t vector);
+
+void ioapic_init(uintptr_t physical_address);
+// sends the io apic input pin as vector to the given local apic
+void ioapic_route(uint8_t pin, uint8_t vector, uint8_t apic_id);
+
+// 1 once the interrupts are delivered through the apic instead of the pic
+uint8_t apic_enabled();
@@ -0,0 +1,172 @@
+#include "mp.h"
+#include <memutils.h>
+#include <stdint.h>
+
+struct mp_floating_pointer {
+    char signature[4]; // "_MP_"
+    uint32_t configuration_table;
+    uint8_t length; // in 16 byte units
+    uint8_t revision;
+    uint8_t checksum;
+    uint8_t features[5];
+} __attribute__((packed));
+
+struct mp_configuration_header {
+    char signature[4]; // "PCMP"
+    uint16_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[8];
+    char product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_table_size;
+    uint16_t number_of_entries;
+    uint32_t lapic_address;
+    uint16_t extended_length;
+    uint8_t extended_checksum;
+    uint8_t reserved;
+} __attribute__((packed));
+
+enum {
+    MP_ENTRY_PROCESSOR = 0,
+    MP_ENTRY_BUS = 1,
+    MP_ENTRY_IOAPIC = 2,
+    MP_ENTRY_IO_INTERRUPT = 3,
+    MP_ENTRY_LOCAL_INTERRUPT = 4,
+};
+
+struct mp_processor_entry {
+    uint8_t type;
+    uint8_t apic_id;
+    uint8_t apic_version;
+    uint8_t flags; // bit 0 enabled, bit 1 bootstrap processor
+    uint32_t signature;
+    uint32_t features;
+    uint32_t reserved[2];
+} __attribute__((packed));
+
+struct mp_bus_entry {
+    uint8_t type;
+    uint8_t bus_id;
+    char bus_type[6];
+} __attribute__((packed));
+
+struct mp_ioapic_entry {
+    uint8_t type;
+    uint8_t apic_id;
+    uint8_t apic_version;
+    uint8_t flags;
+    uint32_t address;
+} __attribute__((packed));
+
+struct mp_interrupt_entry {
+    uint8_t type;
+    uint8_t interrupt_type;
+    uint16_t flags;
+    uint8_t source_bus;
+    uint8_t source_irq;
+    uint8_t destination_apic;
+    uint8_t destination_pin;
+} __attribute__((packed));
+
+uint8_t mp_checksum(void* data, uint32_t length)
+{
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        sum += ((uint8_t*)data)[i];
+    }
+    return sum;
+}
+
+struct mp_floating_pointer* mp_search(uintptr_t start, uint32_t length)
+{
+    for (uintptr_t address = start; address < start + length; address += 16) {
+        struct mp_floating_pointer* pointer = (struct mp_floating_pointer*)address;
+        if (memcmp(pointer->signature, "_MP_", 4) == 0 && mp_checksum(pointer, pointer->length * 16) == 0) {
+            return pointer;
+        }
+    }
+    return NULL;
+}
+
+int mp_find_configuration(struct mp_configuration* configuration, uint32_t max_processors)
+{
+    // first kb of the extended bios data area, last kb of base memory and the bios rom
+    uintptr_t ebda = *(uint16_t*)0x40E << 4;
+    struct mp_floating_pointer* pointer = NULL;
+    if (ebda != 0) {
+        pointer = mp_search(ebda, 1024);
+    }
+    if (pointer == NULL) {
+        pointer = mp_search(0x9FC00, 1024);
+    }
+    if (pointer == NULL) {
+        pointer = mp_search(0xF0000, 0x10000);
+    }
+    if (pointer == NULL || pointer->configuration_table == 0) {
+        return 1; // no tables or one of the default configurations
+    }
+
+    struct mp_configuration_header* header = (struct mp_configuration_header*)pointer->configuration_table;
+    if (memcmp(header->signature, "PCMP", 4) != 0 || mp_checksum(header, header->length) != 0) {
+        return 1;
+    }
+
+    memset(configuration, 0, sizeof(struct mp_configuration));
+    configuration->lapic_address = header->lapic_address;
+    for (uint8_t i = 0; i < 16; i++) {
+        configuration->isa_irq_pins[i] = i;
+    }
+
+    int16_t isa_bus = -1;
+    uint8_t* entry = (uint8_t*)(header + 1);
+    for (uint16_t i = 0; i < header->number_of_entries; i++) {
+        switch (*entry) {
+        case MP_ENTRY_PROCESSOR: {
+            struct mp_processor_entry* processor = (struct mp_processor_entry*)entry;
+            if ((processor->flags & 0x1) && configuration->number_of_processors < max_processors) {
+                if (processor->flags & 0x2) {
+                    configuration->bsp_apic_id = processor->apic_id;
+                }
+                configuration->apic_ids[configuration->number_of_processors] = processor->apic_id;
+                configuration->number_of_processors++;
+            }
+            entry += sizeof(struct mp_processor_entry);
+            break;
+        }
+        case MP_ENTRY_BUS: {
+            struct mp_bus_entry* bus = (struct mp_bus_entry*)entry;
+            if (memcmp(bus->bus_type, "ISA", 3) == 0) {
+                isa_bus = bus->bus_id;
+            }
+            entry += sizeof(struct mp_bus_entry);
+            break;
+        }
+        case MP_ENTRY_IOAPIC: {
+            struct mp_ioapic_entry* ioapic = (struct mp_ioapic_entry*)entry;
+            if ((ioapic->flags & 0x1) && configuration->ioapic_address == 0) {
+                configuration->ioapic_address = ioapic->address;
+            }
+            entry += sizeof(struct mp_ioapic_entry);
+            break;
+        }
+        case MP_ENTRY_IO_INTERRUPT: {
+            struct mp_interrupt_entry* interrupt = (struct mp_interrupt_entry*)entry;
+            // bus entries come first so the isa bus id is known here
+            if (interrupt->interrupt_type == 0 && interrupt->source_bus == isa_bus && interrupt->source_irq < 16) {
+                configuration->isa_irq_pins[interrupt->source_irq] = interrupt->destination_pin;
+            }
+            entry += sizeof(struct mp_interrupt_entry);
+            break;
+        }
+        default:
+            entry += 8; // local interrupt entries and anything unknown
+            break;
+        }
+    }
+
+    if (configuration->number_of_processors == 0 || configuration->ioapic_address == 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// Intel MultiProcessor Specification tables, the bios leaves them in the first 1MB
+// https://wiki.osdev.org/Symmetric_Multiprocessing
+
+struct mp_configuration {
+    uintptr_t lapic_address;
+    uintptr_t ioapic_address;
+    uint8_t bsp_apic_id;
+    uint8_t number_of_processors;
+    uint8_t apic_ids[16];
+    uint8_t isa_irq_pins[16]; // io apic input pin for each isa irq
+};
+
+// returns 0 on success
+int mp_find_configuration(struct mp_configuration* configuration, uint32_t max_processors);
@@ -0,0 +1,200 @@
+#include "smp.h"
+#include "apic.h"
+#include "mp.h"
+#include <heap.h>
+#include <idt.h>
+#include <inboutb.h>
+#include <interrupts/irq_handlers.h>
+#include <interrupts/system_calls.h>
+#include <memutils.h>
+#include <pager.h>
+#include <pic.h>
+#include <pit.h>
+#include <print.h>
+#include <process.h>
+#include <stdint.h>
+#include <timer.h>
+
+#define TRAMPOLINE_BASE 0x8000
+
+extern uint8_t ap_trampoline_start[];
+extern uint8_t ap_trampoline_end[];
+extern uint32_t ap_trampoline_cr3[];
+extern uint32_t ap_trampoline_stack[];
+extern uint32_t ap_trampoline_entry[];
+
+struct cpu cpus[MAX_CPUS];
+uint32_t number_of_cpus = 1;
+
+// apic ids don't have to be sequential
+uint8_t cpu_index_by_apic_id[256] = { 0 };
+
+void smp_reschedule(uint32_t cpu_index)
+{
+    if (!apic_enabled() || cpu_index == get_cpu_index() || cpu_index >= number_of_cpus) {
+        return;
+    }
+    lapic_send_ipi(cpus[cpu_index].apic_id, 32);
+}
+
+uint32_t get_cpu_index()
+{
+    if (!apic_enabled()) {
+        return 0;
+    }
+    return cpu_index_by_apic_id[lapic_id()];
+}
+
+// returns the address of a trampoline variable in the copy at TRAMPOLINE_BASE
+uint32_t* trampoline_variable(uint32_t* variable)
+{
+    return (uint32_t*)(TRAMPOLINE_BASE + ((uint8_t*)variable - ap_trampoline_start));
+}
+
+void ap_main()
+{
+    struct cpu* cpu = &cpus[cpu_index_by_apic_id[lapic_id()]];
+
+    // enable sse
+    __asm__ volatile("mov %cr0, %eax\n\t"
+                     "and $0xfffb, %ax\n\t"
+                     "or  $0x2, %ax\n\t"
+                     "mov %eax, %cr0\n\t"
+                     "mov %cr4, %eax\n\t"
+                     "or  $(3 << 9), %ax\n\t"
+                     "mov %eax, %cr4\n\t");
+
+    // write protect, same as the bootstrap processor
+    __asm__ volatile("mov %cr0, %eax\n\t"
+                     "or  $(1 << 16), %eax\n\t"
+                     "mov %eax, %cr0\n\t");
+
+    // every cpu needs its own tss since the busy flag lives in the descriptor
+    cpu->tss.esp0 = (uint32_t)cpu->stack + AP_STACK_SIZE;
+    cpu->tss.ss0 = 0x10;
+    cpu->tss.io_bitmap_base = sizeof(struct TSS);
+
+    uint32_t base = (uint32_t)&cpu->tss;
+    uint32_t limit = sizeof(struct TSS) - 1;
+    cpu->gdt[0] = 0;
+    cpu->gdt[1] = 0x00CF9A000000FFFF;
+    cpu->gdt[2] = 0x00CF92000000FFFF;
+    cpu->gdt[3] = (uint64_t)(limit & 0xFFFF) | ((uint64_t)(base & 0xFFFFFF) << 16) | ((uint64_t)0b10001001 << 40)
+        | ((uint64_t)((limit >> 16) & 0xF) << 48) | ((uint64_t)(base >> 24) << 56);
+
+    struct {
+        uint16_t limit;
+        uint32_t base;
+    } __attribute__((packed)) gdt_descriptor = { sizeof(cpu->gdt) - 1, (uint32_t)cpu->gdt };
+
+    __asm__ volatile("lgdt (%0)\n\t"
+                     "ljmp $0x08, $1f\n\t"
+                     "1:\n\t"
+                     "mov $0x10, %%ax\n\t"
+                     "mov %%ax, %%ds\n\t"
+                     "mov %%ax, %%es\n\t"
+                     "mov %%ax, %%fs\n\t"
+                     "mov %%ax, %%gs\n\t"
+                     "mov %%ax, %%ss\n\t"
+                     :
+                     : "r"(&gdt_descriptor)
+                     : "eax", "memory");
+    __asm__ volatile("ltr %%ax" : : "a"((3 << 3) | 0x0));
+
+    struct IDTPointer idt_pointer = { .limit = 0xffff, .base = IDT_BASE };
+    __asm__ volatile("lidt (%0)" : : "r"(&idt_pointer));
+
+    init_sysenter(cpu->tss.esp0);
+
+    lapic_enable();
+    timer_start();
+
+    cpu->started = 1;
+
+    // this becomes the idle process of the cpu on the first timer interrupt
+    __asm__ volatile("sti");
+    while (1)
+        __asm__ volatile("hlt");
+}
+
+void smp_init()
+{
+    struct mp_configuration configuration;
+    if (mp_find_configuration(&configuration, MAX_CPUS) != 0 || configuration.number_of_processors < 2) {
+        printf("Running on a single cpu\n");
+        return;
+    }
+
+    lapic_init(configuration.lapic_address);
+    ioapic_init(configuration.ioapic_address);
+
+    // everything goes through the io apic from now on
+    outb(PIC1_DATA, 0xFF);
+    outb(PIC2_DATA, 0xFF);
+
+    struct IDTEntry* idt_entries = (struct IDTEntry*)IDT_BASE;
+    idt_entries[LAPIC_SPURIOUS_VECTOR] = make_idt_entry((uint32_t*)apic_spurious, 0x8, 0xE);
+
+    uint8_t bsp_id = lapic_id();
+    cpus[0].index = 0;
+    cpus[0].apic_id = bsp_id;
+    cpus[0].started = 1;
+    cpu_index_by_apic_id[bsp_id] = 0;
+
+    lapic_enable();
+    lapic_timer_calibrate(); // the timer itself is started by main
+    ioapic_route(configuration.isa_irq_pins[1], 33, bsp_id); // keyboard
+
+    memcpy((void*)TRAMPOLINE_BASE, ap_trampoline_start, ap_trampoline_end - ap_trampoline_start);
+
+    for (uint32_t i = 0; i < configuration.number_of_processors; i++) {
+        uint8_t apic_id = configuration.apic_ids[i];
+        if (apic_id == bsp_id) {
+            continue;
+        }
+
+        struct cpu* cpu = &cpus[number_of_cpus];
+        cpu->index = number_of_cpus;
+        cpu->apic_id = apic_id;
+        cpu->started = 0;
+        cpu->stack = malloc(AP_STACK_SIZE);
+        if (cpu->stack == NULL) {
+            printf("Failed to malloc stack for cpu %d\n", apic_id);
+            break;
+        }
+        cpu_index_by_apic_id[apic_id] = cpu->index;
+
+        uint32_t stack_top = ((uint32_t)cpu->stack + AP_STACK_SIZE - 16) & ~0xF;
+        char name[] = "idle0";
+        name[4] = '0' + cpu->index % 10;
+        struct process* idle = create_idle_process(name, stack_top, kernel_table, cpu->index);
+        if (idle == NULL) {
+            free(cpu->stack);
+            break;
+        }
+
+        *trampoline_variable(ap_trampoline_cr3) = (uint32_t)&kernel_table->pde;
+        *trampoline_variable(ap_trampoline_stack) = stack_top;
+        *trampoline_variable(ap_trampoline_entry) = (uint32_t)ap_main;
+
+        // init, then startup twice as the spec says
+        lapic_send_init(apic_id);
+        pit_wait_us(10000);
+        lapic_send_startup(apic_id, TRAMPOLINE_BASE >> 12);
+        pit_wait_us(200);
+        lapic_send_startup(apic_id, TRAMPOLINE_BASE >> 12);
+
+        for (uint32_t wait = 0; wait < 100 && !cpu->started; wait++) {
+            pit_wait_us(1000);
+        }
+        if (!cpu->started) {
+            printf("Cpu %d did not start\n", apic_id);
+            remove_process(idle->id);
+            free(cpu->stack);
+            continue;
+        }
+        number_of_cpus++;
+    }
+
+    printf("Started %d cpus\n", number_of_cpus);
+}
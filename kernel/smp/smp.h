@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+#include <tss.h>
+
+#define MAX_CPUS 16
+#define AP_STACK_SIZE 0x2000
+
+struct cpu {
+    uint32_t index;
+    uint8_t apic_id;
+    volatile uint8_t started;
+    uint64_t gdt[4]; // null, code, data, tss, same layout as the boot gdt
+    struct TSS tss;
+    uint8_t* stack;
+};
+
+extern struct cpu cpus[MAX_CPUS];
+extern uint32_t number_of_cpus;
+
+// finds the other cpus and starts them, stays on the pic with a single cpu
+// must be called after the kernel table is loaded and before interrupts are enabled
+void smp_init();
+
+// index of the cpu running the code, 0 is the bootstrap processor
+uint32_t get_cpu_index();
+
+// makes another cpu run its scheduler, used when work is queued on a cpu that may be waiting on a long deadline
+void smp_reschedule(uint32_t cpu_index);
@@ -0,0 +1,67 @@
+; application processor start up code
+; the startup ipi starts the aps in real mode at 0x8000, so this is copied there before they are woken up
+; https://wiki.osdev.org/Symmetric_Multiprocessing
+[bits 16]
+global ap_trampoline_start
+global ap_trampoline_end
+global ap_trampoline_cr3
+global ap_trampoline_stack
+global ap_trampoline_entry
+
+TRAMPOLINE_BASE equ 0x8000
+%define ADDR(label) (TRAMPOLINE_BASE + (label - ap_trampoline_start))
+
+ap_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    lgdt [ADDR(trampoline_gdt_descriptor)]
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+    jmp dword 0x08:ADDR(trampoline_protected_mode)
+
+[bits 32]
+trampoline_protected_mode:
+    mov ax, 0x10
+    mov ds, ax
+    mov ss, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+
+    mov eax, [ADDR(ap_trampoline_cr3)]
+    mov cr3, eax
+
+    mov eax, cr0
+    or eax, 1 << 31
+    mov cr0, eax ; enable paging
+
+    mov eax, cr4
+    or eax, 1 << 7 ; enable global pages
+    mov cr4, eax
+
+    mov esp, [ADDR(ap_trampoline_stack)]
+    mov eax, [ADDR(ap_trampoline_entry)]
+    call eax
+
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+align 8
+trampoline_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF ; code
+    dq 0x00CF92000000FFFF ; data
+trampoline_gdt_descriptor:
+    dw 3 * 8 - 1
+    dd ADDR(trampoline_gdt)
+
+; filled in by the bsp before each ap is started
+ap_trampoline_cr3: dd 0
+ap_trampoline_stack: dd 0
+ap_trampoline_entry: dd 0
+ap_trampoline_end:
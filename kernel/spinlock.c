@@ -0,0 +1,44 @@
+#include "spinlock.h"
+#include <stdint.h>
+
+spinlock_t kernel_lock = SPINLOCK_INIT;
+
+void spin_lock(spinlock_t* lock)
+{
+    while (__sync_lock_test_and_set(&lock->locked, 1)) {
+        while (lock->locked) {
+            __asm__ volatile("pause");
+        }
+    }
+}
+
+void spin_unlock(spinlock_t* lock)
+{
+    __sync_lock_release(&lock->locked);
+}
+
+uint8_t spin_trylock(spinlock_t* lock)
+{
+    return __sync_lock_test_and_set(&lock->locked, 1) == 0;
+}
+
+uint32_t spin_lock_irqsave(spinlock_t* lock)
+{
+    uint32_t eflags;
+    __asm__ volatile("pushf\n\t"
+                     "pop %0\n\t"
+                     "cli\n\t"
+                     : "=r"(eflags)
+                     :
+                     : "memory");
+    spin_lock(lock);
+    return eflags;
+}
+
+void spin_unlock_irqrestore(spinlock_t* lock, uint32_t eflags)
+{
+    spin_unlock(lock);
+    if (eflags & (1 << 9)) {
+        __asm__ volatile("sti" ::: "memory");
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t locked;
+} spinlock_t;
+
+#define SPINLOCK_INIT { 0 }
+
+// big kernel lock, held while running system calls and while reaping processes
+extern spinlock_t kernel_lock;
+
+void spin_lock(spinlock_t* lock);
+void spin_unlock(spinlock_t* lock);
+// returns 1 if the lock was taken
+uint8_t spin_trylock(spinlock_t* lock);
+
+// for locks that are also taken from interrupt handlers, returns the eflags to restore
+uint32_t spin_lock_irqsave(spinlock_t* lock);
+void spin_unlock_irqrestore(spinlock_t* lock, uint32_t eflags);
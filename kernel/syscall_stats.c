@@ -0,0 +1,70 @@
+#include "syscall_stats.h"
+#include <heap.h>
+#include <memutils.h>
+#include <process.h>
+
+#ifdef SYSCALL_STATS
+struct syscall_stats global_syscall_stats;
+
+struct syscall_stats* syscall_stats_create()
+{
+    struct syscall_stats* stats = malloc(sizeof(struct syscall_stats));
+    if (stats != NULL) {
+        syscall_stats_reset(stats);
+    }
+    return stats;
+}
+
+static void add_call(struct syscall_stat* stat, uint32_t bucket, uint64_t time)
+{
+    stat->count++;
+    stat->time += time;
+    stat->buckets[bucket]++;
+}
+
+void syscall_stats_record(struct process* process, uint32_t number, uint64_t time)
+{
+    if (number >= SYSCALL_TABLE_SIZE) {
+        return;
+    }
+    // anything past 32 bits goes into the last bucket
+    uint32_t bucket = SYSCALL_STATS_BUCKETS - 1;
+    if (time >> 32 == 0) {
+        bucket = (uint32_t)time < 2 ? 0 : 31 - __builtin_clz((uint32_t)time);
+    }
+    add_call(&global_syscall_stats.calls[number], bucket, time);
+    if (process != NULL && process->syscall_stats != NULL) {
+        add_call(&process->syscall_stats->calls[number], bucket, time);
+    }
+}
+
+void syscall_stats_reset(struct syscall_stats* stats)
+{
+    memset(stats == NULL ? &global_syscall_stats : stats, 0, sizeof(struct syscall_stats));
+}
+
+uint32_t syscall_stats_get_records(struct syscall_stats* stats, uint32_t process_id, struct syscall_stats_record* buffer, uint32_t max_entries)
+{
+    if (stats == NULL) {
+        stats = &global_syscall_stats;
+    }
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < SYSCALL_TABLE_SIZE && (buffer == NULL || count < max_entries); i++) {
+        struct syscall_stat* stat = &stats->calls[i];
+        if (stat->count == 0) {
+            continue;
+        }
+        if (buffer != NULL) {
+            struct syscall_stats_record* record = &buffer[count];
+            record->process_id = process_id;
+            record->number = i;
+            record->count = stat->count;
+            record->reserved = 0;
+            record->time = stat->time;
+            memcpy(record->buckets, stat->buckets, sizeof(record->buckets));
+        }
+        count++;
+    }
+    return count;
+}
+#endif
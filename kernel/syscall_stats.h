@@ -0,0 +1,48 @@
+#pragma once
+
+#include <interrupts/system_calls.h>
+#include <stdint.h>
+
+// counts and latencies of system calls, only collected when built with SYSCALL_STATS, syscall_stats.c is empty otherwise
+// bucket i counts the calls that took [2^i, 2^(i+1)) tsc ticks, the first one also holds calls under 2 ticks
+#define SYSCALL_STATS_BUCKETS 32
+
+struct process;
+
+struct syscall_stat {
+    uint32_t count;
+    uint64_t time; // total tsc ticks, blocking calls include the time they waited
+    uint32_t buckets[SYSCALL_STATS_BUCKETS];
+};
+
+struct syscall_stats {
+    struct syscall_stat calls[SYSCALL_TABLE_SIZE];
+};
+
+// one system call number of one process as exposed through /sys/syscalls
+struct syscall_stats_record {
+    uint32_t process_id; // PROCESS_INVALID_ID for the numbers of the whole system
+    uint32_t number;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t time;
+    uint32_t buckets[SYSCALL_STATS_BUCKETS];
+};
+
+enum {
+    // arg points to the id of the process to reset, PROCESS_INVALID_ID resets every process and the global numbers
+    SYSCALL_STATS_RESET = 0,
+};
+
+// returns NULL if there's no memory left, the process is then only counted in the global numbers
+struct syscall_stats* syscall_stats_create();
+
+// adds a call made by process, which can be NULL, to its numbers and the global ones, called with kernel_lock held
+void syscall_stats_record(struct process* process, uint32_t number, uint64_t time);
+
+// stats NULL resets the global numbers
+void syscall_stats_reset(struct syscall_stats* stats);
+
+// writes a record for every number that was called, stats NULL is the global numbers
+// buffer NULL only counts the records
+uint32_t syscall_stats_get_records(struct syscall_stats* stats, uint32_t process_id, struct syscall_stats_record* buffer, uint32_t max_entries);
@@ -0,0 +1,98 @@
+#include "proc.h"
+#include <heap.h>
+#include <memutils.h>
+#include <process.h>
+#include <stdint.h>
+
+VFSFile* proc_open(VFSIndexNode* inode)
+{
+    VFSFile* file = (VFSFile*)malloc(sizeof(VFSFile));
+    if (file == NULL) {
+        return NULL;
+    }
+    uint32_t max_entries = get_number_of_processes();
+    struct process_info* snapshot = malloc(sizeof(struct process_info) * max_entries);
+    if (snapshot == NULL) {
+        free(file);
+        return NULL;
+    }
+    file->private_data = snapshot;
+    file->private_data_size = get_process_info(snapshot, max_entries) * sizeof(struct process_info);
+    file->inode = inode;
+    file->position = 0;
+    return file;
+}
+
+void proc_close(VFSFile* file)
+{
+    free(file->private_data);
+    free(file);
+}
+
+// only whole records are copied
+uint32_t proc_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    uint32_t remaining = file->private_data_size - file->position;
+    uint32_t read_length = buffer_size - buffer_size % sizeof(struct process_info);
+    if (read_length > remaining) {
+        read_length = remaining;
+    }
+    memcpy(buffer, (uint8_t*)file->private_data + file->position, read_length);
+    file->position += read_length;
+    return read_length;
+}
+
+uint32_t proc_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    (void)file;
+    (void)buffer;
+    (void)buffer_size;
+    return 0;
+}
+
+void proc_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg)
+{
+    (void)file;
+    (void)command;
+    (void)arg;
+}
+
+void proc_seek(VFSFile* file, uint32_t offset, uint32_t whence)
+{
+    switch (whence) {
+    case VFS_BEG:
+        file->position = offset;
+        break;
+    case VFS_CUR:
+        file->position += offset;
+        break;
+    case VFS_END:
+        file->position = file->private_data_size + offset;
+        break;
+    }
+    if (file->position > file->private_data_size) {
+        file->position = file->private_data_size;
+    }
+}
+
+uint32_t proc_tell(VFSFile* file) { return file->position; }
+
+void proc_flush(VFSFile* file)
+{
+    (void)file;
+}
+
+VFSFileOperations get_proc_file_operations()
+{
+    VFSFileOperations fops = {
+        .open = (void*)proc_open,
+        .close = (void*)proc_close,
+        .read = (void*)proc_read,
+        .write = (void*)proc_write,
+        .ioctl = (void*)proc_ioctl,
+        .seek = (void*)proc_seek,
+        .tell = (void*)proc_tell,
+        .flush = (void*)proc_flush,
+    };
+    return fops;
+}
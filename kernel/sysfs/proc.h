@@ -0,0 +1,8 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+// /sys/proc, reads return struct process_info records of a snapshot taken when the file was opened
+// seek 0 from VFS_BEG to read the snapshot again, reopen the file for fresh numbers
+VFSFileOperations get_proc_file_operations();
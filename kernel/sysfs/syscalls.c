@@ -0,0 +1,105 @@
+#include "syscalls.h"
+#include <heap.h>
+#include <memutils.h>
+#include <process.h>
+#include <stdint.h>
+#include <syscall_stats.h>
+
+#ifdef SYSCALL_STATS
+VFSFile* syscalls_open(VFSIndexNode* inode)
+{
+    VFSFile* file = (VFSFile*)malloc(sizeof(VFSFile));
+    if (file == NULL) {
+        return NULL;
+    }
+    uint32_t max_entries = get_syscall_stats(NULL, 0);
+    // right after a reset there can be nothing to read
+    struct syscall_stats_record* snapshot = malloc(sizeof(struct syscall_stats_record) * (max_entries == 0 ? 1 : max_entries));
+    if (snapshot == NULL) {
+        free(file);
+        return NULL;
+    }
+    file->private_data = snapshot;
+    file->private_data_size = get_syscall_stats(snapshot, max_entries) * sizeof(struct syscall_stats_record);
+    file->inode = inode;
+    file->position = 0;
+    return file;
+}
+
+void syscalls_close(VFSFile* file)
+{
+    free(file->private_data);
+    free(file);
+}
+
+// only whole records are copied
+uint32_t syscalls_read(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    uint32_t remaining = file->private_data_size - file->position;
+    uint32_t read_length = buffer_size - buffer_size % sizeof(struct syscall_stats_record);
+    if (read_length > remaining) {
+        read_length = remaining;
+    }
+    memcpy(buffer, (uint8_t*)file->private_data + file->position, read_length);
+    file->position += read_length;
+    return read_length;
+}
+
+uint32_t syscalls_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    (void)file;
+    (void)buffer;
+    (void)buffer_size;
+    return 0;
+}
+
+void syscalls_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg)
+{
+    (void)file;
+    switch (*command) {
+    case SYSCALL_STATS_RESET:
+        reset_syscall_stats(arg == NULL ? PROCESS_INVALID_ID : *arg);
+        break;
+    }
+}
+
+void syscalls_seek(VFSFile* file, uint32_t offset, uint32_t whence)
+{
+    switch (whence) {
+    case VFS_BEG:
+        file->position = offset;
+        break;
+    case VFS_CUR:
+        file->position += offset;
+        break;
+    case VFS_END:
+        file->position = file->private_data_size + offset;
+        break;
+    }
+    if (file->position > file->private_data_size) {
+        file->position = file->private_data_size;
+    }
+}
+
+uint32_t syscalls_tell(VFSFile* file) { return file->position; }
+
+void syscalls_flush(VFSFile* file)
+{
+    (void)file;
+}
+
+VFSFileOperations get_syscalls_file_operations()
+{
+    VFSFileOperations fops = {
+        .open = (void*)syscalls_open,
+        .close = (void*)syscalls_close,
+        .read = (void*)syscalls_read,
+        .write = (void*)syscalls_write,
+        .ioctl = (void*)syscalls_ioctl,
+        .seek = (void*)syscalls_seek,
+        .tell = (void*)syscalls_tell,
+        .flush = (void*)syscalls_flush,
+    };
+    return fops;
+}
+#endif
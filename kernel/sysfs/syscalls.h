@@ -0,0 +1,9 @@
+#pragma once
+
+#include <filesystem/virtual-filesystem.h>
+#include <stdint.h>
+
+// /sys/syscalls, only created when built with SYSCALL_STATS
+// reads return struct syscall_stats_record records of a snapshot taken when the file was opened, the global numbers come first
+// ioctl SYSCALL_STATS_RESET clears the numbers, see syscall_stats.h
+VFSFileOperations get_syscalls_file_operations();
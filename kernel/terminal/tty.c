@@ -82,12 +82,21 @@ uint32_t tty_read(VFSFile* file, void* buffer, uint32_t buffer_size)
 
     return read_length;
 }
-uint32_t tty_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+uint32_t tty_writev(VFSFile* file, VFSIOVector* vectors, uint32_t count)
 {
-    for (uint32_t i = 0; i < buffer_size; i++) {
-        print_char(((char*)buffer)[i]);
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = 0; j < vectors[i].length; j++) {
+            print_char(((char*)vectors[i].buffer)[j]);
+        }
+        total += vectors[i].length;
     }
-    return buffer_size;
+    return total;
+}
+uint32_t tty_write(VFSFile* file, void* buffer, uint32_t buffer_size)
+{
+    VFSIOVector vector = { .buffer = buffer, .length = buffer_size };
+    return tty_writev(file, &vector, 1);
 }
 void tty_ioctl(VFSFile* file, uint32_t* command, uint32_t* arg)
 {
@@ -122,6 +131,7 @@ VFSFileOperations get_tty_file_operations()
         .close = (void*)tty_close,
         .read = (void*)tty_read,
         .write = (void*)tty_write,
+        .writev = (void*)tty_writev,
         .ioctl = (void*)tty_ioctl,
         .seek = (void*)tty_seek,
         .tell = (void*)tty_tell,
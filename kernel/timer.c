@@ -0,0 +1,43 @@
+#include "timer.h"
+#include <inboutb.h>
+#include <pit.h>
+#include <smp/apic.h>
+#include <stdint.h>
+
+#define TIMER_VECTOR 32
+
+void timer_start()
+{
+#ifdef TICKLESS
+    timer_set_deadline(TIMER_MAX_DEADLINE_NS);
+#else
+    if (apic_enabled()) {
+        lapic_timer_start(TIMER_HZ, TIMER_VECTOR);
+    }
+    // the pit is already running in periodic mode since kernel_entry
+#endif
+}
+
+void timer_set_deadline(uint64_t nanoseconds)
+{
+    if (nanoseconds == 0) {
+        nanoseconds = 1;
+    }
+
+    if (apic_enabled()) {
+        lapic_timer_oneshot(nanoseconds, TIMER_VECTOR);
+        return;
+    }
+
+    if (nanoseconds > PIT_MAX_DEADLINE_NS) {
+        nanoseconds = PIT_MAX_DEADLINE_NS;
+    }
+    // fits in 32 bits after the clamp
+    uint32_t count = (uint32_t)nanoseconds / 1000 * (PIT_FREQUENCY / 1000) / 1000;
+    if (count == 0) {
+        count = 1;
+    }
+    outb(0x43, 0x30); // Channel 0, LSB then MSB, mode 0 (interrupt on terminal count)
+    outb(0x40, (uint8_t)(count & 0xFF));
+    outb(0x40, (uint8_t)((count >> 8) & 0xFF));
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// the scheduler timer of each cpu, the local apic timer when the apic is used and pit channel 0 otherwise
+// with TICKLESS the timer is one shot and the scheduler programs the next deadline on every switch
+// without it the timer fires every 1 / TIMER_HZ seconds
+
+// longest the scheduler lets a cpu go without an interrupt
+#define TIMER_MAX_DEADLINE_NS 1000000000ull
+// pit channel 0 counts 16 bits, so one shots are at most ~54ms
+#define PIT_MAX_DEADLINE_NS 54000000ull
+
+// starts the timer of the calling cpu
+void timer_start();
+
+// fires the timer of the calling cpu after the given number of nanoseconds, only used with TICKLESS
+void timer_set_deadline(uint64_t nanoseconds);
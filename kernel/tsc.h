@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+static inline uint64_t read_tsc()
+{
+    uint64_t tsc;
+    __asm__ volatile("rdtsc" : "=A"(tsc));
+    return tsc;
+}
@@ -30,8 +30,14 @@ typedef struct
     void (*seek)(void *file, uint32_t offset, Whence whence);
     uint32_t (*tell)(void *file);
     void (*flush)(void *file);
+    uint32_t (*readv)(void *file, void *vectors, uint32_t count);
+    uint32_t (*writev)(void *file, void *vectors, uint32_t count);
+    uint8_t (*submit)(void *file, void *request);
+    uint32_t (*transfer)(void *file, void *out, uint32_t length);
     void *private_data;
     uint32_t number_of_references;
+    uint32_t version;
+    void *dentry;
 } IndexNode;
 
 typedef struct
@@ -42,53 +48,177 @@ typedef struct
     uint32_t position;
 } File;
 
+// one buffer of read_file_vectored and write_file_vectored
+typedef struct
+{
+    void *buffer;
+    uint32_t length;
+} IOVector;
+
+// metadata of stat_file and stat_open_file
+typedef struct
+{
+    uint32_t type; // 1 file, 2 directory, 3 character device, 4 pipe
+    uint32_t size;
+    uint32_t version; // changes with every write
+    uint32_t flags;
+} FileStat;
+
+enum
+{
+    FILE_STAT_DEVICE = 1,
+};
+
+// one entry of get_directory_entries, the records are packed one after the other
+typedef struct
+{
+    uint32_t inode_number; // 0 for device files
+    uint32_t size;
+    uint16_t record_length; // bytes to the next record
+    uint16_t name_length;
+    uint8_t type; // 1 file, 2 directory, 3 character device
+    char name[]; // null terminated
+} DirectoryRecord;
+
+#define DIRECTORY_COOKIE_START 0
+// the cookie once every entry was listed
+#define DIRECTORY_COOKIE_END 0xFFFFFFFF
+
 static inline File *open_file(char *path, FileFlags flags)
 {
     File *ret = 0;
-    __asm__ volatile("int $0x40\n\t" : "=b"(ret) : "a"(SYSCALL_OPEN), "b"(path), "c"(flags));
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(ret) : "a"(SYSCALL_OPEN), "b"(path), "c"(flags));
     return ret;
 }
 
 static inline void close_file(File *file)
 {
-    __asm__ volatile("int $0x40\n\t" ::"a"(SYSCALL_CLOSE), "b"(file));
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(SYSCALL_CLOSE), "b"(file));
 }
 
 static inline uint32_t read_file(File *file, void *buffer, uint32_t buffer_size)
 {
     uint32_t ret;
-    __asm__ volatile("int $0x40\n\t" : "=a"(ret) : "a"(SYSCALL_READ), "b"(file), "c"(buffer_size), "d"(buffer));
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_READ), "b"(file), "c"(buffer_size), "d"(buffer));
     return ret;
 }
 
 static inline uint32_t write_file(File *file, void *buffer, uint32_t buffer_size)
 {
     uint32_t ret;
-    __asm__ volatile("int $0x40\n\t" : "=a"(ret) : "a"(SYSCALL_WRITE), "b"(file), "c"(buffer_size), "d"(buffer));
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_WRITE), "b"(file), "c"(buffer_size), "d"(buffer));
+    return ret;
+}
+
+// fills the vectors in order with one system call, stops at the first vector that isn't filled
+// returns the total number of bytes read
+static inline uint32_t read_file_vectored(File *file, IOVector *vectors, uint32_t count)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_READV), "b"(file), "c"(count), "d"(vectors) : "memory");
+    return ret;
+}
+
+// writes the vectors in order with one system call, returns the total number of bytes written
+static inline uint32_t write_file_vectored(File *file, IOVector *vectors, uint32_t count)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_WRITEV), "b"(file), "c"(count), "d"(vectors) : "memory");
+    return ret;
+}
+
+// copies up to length bytes from the position of in to out inside the kernel, returns the number of bytes written
+static inline uint32_t send_file(File *out, File *in, uint32_t length)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_SEND_FILE), "b"(out), "c"(in), "d"(length) : "memory");
+    return ret;
+}
+
+// handle of a read or write started with submit_io
+typedef struct AsyncIO AsyncIO;
+
+enum
+{
+    ASYNC_IO_DONE = 0,
+    ASYNC_IO_PENDING = 1,
+    ASYNC_IO_INVALID = 2,
+};
+
+// starts reading or writing buffer_size bytes at the position of the file and returns without waiting for the disk
+// the buffer and the file have to stay valid until the result is collected, returns NULL on fail
+static inline AsyncIO *submit_io(File *file, void *buffer, uint32_t buffer_size, uint32_t write)
+{
+    AsyncIO *ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(ret) : "a"(SYSCALL_SUBMIT_IO), "b"(file), "c"(buffer_size), "d"(buffer), "S"(write) : "memory");
+    return ret;
+}
+
+// collects the number of bytes moved once the request is done, with block set the thread sleeps until then
+// returns ASYNC_IO_DONE and frees the handle, ASYNC_IO_PENDING or ASYNC_IO_INVALID
+static inline uint32_t wait_io(AsyncIO *io, uint32_t block, uint32_t *result)
+{
+    uint32_t status, bytes;
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(status), "=a"(bytes) : "a"(SYSCALL_WAIT_IO), "b"(io), "c"(block) : "memory");
+    *result = bytes;
+    return status;
+}
+
+// makes an anonymous pipe, reads of read_end block until something is written to write_end or it's closed
+// returns 0 on success, both ends are closed with close_file or when a process they were given to as std files exits
+static inline uint32_t create_pipe(File **read_end, File **write_end)
+{
+    File *read, *write;
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(read), "=c"(write) : "a"(SYSCALL_PIPE) : "memory");
+    *read_end = read;
+    *write_end = write;
+    return read == 0;
+}
+
+// reads the metadata without opening the file, returns 0 on success
+static inline uint32_t stat_file(char *path, FileStat *stat)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_STAT), "b"(path), "c"(stat) : "memory");
+    return ret;
+}
+
+static inline void stat_open_file(File *file, FileStat *stat)
+{
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(SYSCALL_FSTAT), "b"(file), "c"(stat) : "memory");
+}
+
+// fills buffer with the records of the entries of the directory after cookie and moves the cookie past them
+// start with DIRECTORY_COOKIE_START and call again until the cookie is DIRECTORY_COOKIE_END, returns the number of bytes used
+// 0 with the cookie not at the end means the listing can't go on: a read error, a missing directory or a record that doesn't fit
+static inline uint32_t get_directory_entries(char *path, uint32_t *cookie, void *buffer, uint32_t buffer_size)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_GET_DIRECTORY_ENTRIES), "b"(path), "c"(buffer_size), "d"(buffer), "S"(cookie) : "memory");
     return ret;
 }
 
 static inline void ioctl(File *file, uint32_t *command, uint32_t *arg)
 {
-    __asm__ volatile("int $0x40\n\t" ::"a"(SYSCALL_IOCTL), "b"(file), "c"(command), "d"(arg));
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(SYSCALL_IOCTL), "b"(file), "c"(command), "d"(arg));
 }
 
 static inline void seek_file(File *file, uint32_t offset, Whence whence)
 {
-    __asm__ volatile("int $0x40\n\t" ::"a"(SYSCALL_SEEK), "b"(file), "c"(offset), "d"(whence));
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(SYSCALL_SEEK), "b"(file), "c"(offset), "d"(whence));
 }
 
 static inline uint32_t tell_file(File *file)
 {
     uint32_t ret;
-    __asm__ volatile("int $0x40\n\t" : "=c"(ret) : "a"(SYSCALL_TELL), "b"(file));
+    __asm__ volatile(ESTROS_SYSCALL : "=c"(ret) : "a"(SYSCALL_TELL), "b"(file));
     return ret;
 }
 
 static inline uint32_t create_file(char *path)
 {
     uint32_t ret;
-    __asm__ volatile("int $0x40\n\t" : "=a"(ret) : "a"(SYSCALL_CREATE_FILE), "b"(path));
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_CREATE_FILE), "b"(path));
     return ret;
 }
 
@@ -0,0 +1,82 @@
+#ifndef ESTROS_INFO_H
+#define ESTROS_INFO_H
+
+#include <estros/file.h>
+#include <stdint.h>
+
+// read only page the kernel maps into every process, shared by its threads (see kernel/info_page.h)
+#define ESTROS_INFO_PAGE_ADDRESS 0xBFFFF000
+#define ESTROS_INFO_PAGE_CHILDREN 16
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t state;
+    uint32_t exit_code;
+    uint32_t reserved;
+} InfoPageChild;
+
+typedef struct
+{
+    volatile uint32_t sequence; // odd while the kernel updates the time fields
+    uint32_t process_id;
+    uint32_t parent_id;
+    File *stdout, *stdin, *stderr;
+    uint64_t monotonic_ns; // clock at the last time the process was scheduled
+    uint32_t ticks;        // scheduler runs on all cpus since boot
+    uint32_t reserved;
+    volatile InfoPageChild children[ESTROS_INFO_PAGE_CHILDREN];
+} InfoPage;
+
+static inline InfoPage *get_info_page()
+{
+    return (InfoPage *)ESTROS_INFO_PAGE_ADDRESS;
+}
+
+// id of the process, threads share it
+static inline uint32_t get_process_id()
+{
+    return get_info_page()->process_id;
+}
+
+// coarse monotonic time, read_tsc with the time page is more precise
+static inline uint64_t get_coarse_time_ns(uint32_t *ticks)
+{
+    InfoPage *page = get_info_page();
+    uint32_t sequence;
+    uint64_t time;
+    do
+    {
+        sequence = page->sequence;
+        __asm__ volatile("" ::: "memory");
+        time = page->monotonic_ns;
+        if (ticks != 0)
+        {
+            *ticks = page->ticks;
+        }
+        __asm__ volatile("" ::: "memory");
+    } while ((sequence & 1) || sequence != page->sequence);
+    return time;
+}
+
+// state of a process started by this one, returns 1 if it isn't one of the last ESTROS_INFO_PAGE_CHILDREN children
+static inline uint32_t get_child_state(uint32_t id, uint32_t *state, uint32_t *exit_code)
+{
+    InfoPage *page = get_info_page();
+    for (uint32_t i = 0; i < ESTROS_INFO_PAGE_CHILDREN; i++)
+    {
+        if (page->children[i].id == id)
+        {
+            *state = page->children[i].state;
+            __asm__ volatile("" ::: "memory");
+            if (exit_code != 0)
+            {
+                *exit_code = page->children[i].exit_code;
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#endif
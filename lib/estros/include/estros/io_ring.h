@@ -0,0 +1,134 @@
+#ifndef ESTROS_IO_RING_H
+#define ESTROS_IO_RING_H
+
+#include <estros/file.h>
+#include <estros/syscall.h>
+#include <stdint.h>
+
+// submission and completion rings shared with the kernel, see kernel/io_ring.h
+// queue entries with io_ring_push, hand them to the kernel with io_ring_submit and collect results with io_ring_pop
+
+#define ESTROS_IO_RING_ENTRIES 64
+
+typedef enum
+{
+    IO_RING_NOP = 0,
+    IO_RING_OPEN = 1,  // address = path, argument = flags, result = file
+    IO_RING_READ = 2,  // address = buffer, length = buffer size, result = bytes read
+    IO_RING_WRITE = 3, // address = buffer, length = buffer size, result = bytes written
+    IO_RING_SEEK = 4,  // length = offset, argument = whence
+    IO_RING_IOCTL = 5, // address = command pointer, argument = arg pointer
+    IO_RING_CLOSE = 6,
+} IoRingOperation;
+
+// submission flags
+enum
+{
+    IO_RING_LINK = 1,              // the next entry only runs if this one succeeded
+    IO_RING_CHAIN_FILE = 1 << 1,   // use the file opened earlier in the chain
+    IO_RING_SKIP_SUCCESS = 1 << 2, // only post a completion on failure
+};
+
+// ring flags
+enum
+{
+    IO_RING_POLL = 1,
+    IO_RING_NEED_WAKEUP = 1 << 1,
+};
+
+enum
+{
+    IO_RING_SUCCESS = 0,
+    IO_RING_FAILED = 1,
+    IO_RING_CANCELED = 2,
+};
+
+typedef struct
+{
+    uint8_t operation;
+    uint8_t flags;
+    uint16_t reserved;
+    File *file;
+    uint32_t address;
+    uint32_t length;
+    uint32_t argument;
+    uint32_t user_data;
+} IoRingSubmission;
+
+typedef struct
+{
+    uint32_t user_data;
+    uint32_t result;
+    uint32_t status;
+    uint32_t reserved;
+} IoRingCompletion;
+
+typedef struct
+{
+    volatile uint32_t submission_head;
+    volatile uint32_t submission_tail;
+    volatile uint32_t completion_head;
+    volatile uint32_t completion_tail;
+    volatile uint32_t flags;
+    uint32_t reserved[3];
+    IoRingSubmission submissions[ESTROS_IO_RING_ENTRIES];
+    IoRingCompletion completions[ESTROS_IO_RING_ENTRIES];
+} IoRing;
+
+// with IO_RING_POLL a kernel thread takes the submissions so io_ring_submit rarely has to make a system call
+// returns NULL on fail or if the process already has a ring
+static inline IoRing *io_ring_setup(uint32_t flags)
+{
+    IoRing *ring;
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(ring) : "a"(SYSCALL_IO_RING_SETUP), "b"(flags) : "memory");
+    return ring;
+}
+
+// returns the number of submissions the kernel took
+static inline uint32_t io_ring_enter(uint32_t min_complete)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_IO_RING_ENTER), "b"(min_complete) : "memory");
+    return ret;
+}
+
+// returns 1 if the submission ring is full
+static inline uint32_t io_ring_push(IoRing *ring, IoRingSubmission *submission)
+{
+    uint32_t tail = ring->submission_tail;
+    if (tail - ring->submission_head >= ESTROS_IO_RING_ENTRIES)
+    {
+        return 1;
+    }
+    ring->submissions[tail & (ESTROS_IO_RING_ENTRIES - 1)] = *submission;
+    __asm__ volatile("" ::: "memory");
+    ring->submission_tail = tail + 1;
+    return 0;
+}
+
+// makes the kernel run the pushed entries, only traps if the ring isn't polled or the polling thread is asleep
+static inline void io_ring_submit(IoRing *ring)
+{
+    // the new tail has to be visible before the flags are read, pairs with the polling thread
+    __sync_synchronize();
+    if (!(ring->flags & IO_RING_POLL) || (ring->flags & IO_RING_NEED_WAKEUP))
+    {
+        io_ring_enter(0);
+    }
+}
+
+// returns 1 and fills completion if one was posted
+static inline uint32_t io_ring_pop(IoRing *ring, IoRingCompletion *completion)
+{
+    uint32_t head = ring->completion_head;
+    if (head == ring->completion_tail)
+    {
+        return 0;
+    }
+    __asm__ volatile("" ::: "memory");
+    *completion = ring->completions[head & (ESTROS_IO_RING_ENTRIES - 1)];
+    ring->completion_head = head + 1;
+    return 1;
+}
+
+#endif
@@ -65,7 +65,7 @@ enum {
 static inline PageTable* create_new_table()
 {
     PageTable* tlb;
-    __asm__ volatile("int $0x40\n\t" : "=b"(tlb) : "a"(SYSCALL_CREATE_NEW_TABLE));
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(tlb) : "a"(SYSCALL_CREATE_NEW_TABLE));
     return tlb;
 }
 
@@ -77,13 +77,13 @@ uintptr_t virt_to_phys(uintptr_t virtual_address, PDETable* table);
 static inline void* new_page(void* physical_address, PDETable* pde_table)
 {
     void* ret;
-    __asm__ volatile("int $0x40\n\t" : "=b"(ret) : "a"(SYSCALL_REQUEST_NEW_PAGE), "b"(physical_address), "d"(pde_table));
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(ret) : "a"(SYSCALL_REQUEST_NEW_PAGE), "b"(physical_address), "d"(pde_table));
     return ret;
 }
 
 static inline void free_page(void* virtual_address, PDETable* pde_table)
 {
-    __asm__ volatile("int $0x40\n\t" : : "a"(SYSCALL_FREE_PAGE), "b"(virtual_address), "d"(pde_table));
+    __asm__ volatile(ESTROS_SYSCALL : : "a"(SYSCALL_FREE_PAGE), "b"(virtual_address), "d"(pde_table));
 }
 
 #endif
@@ -10,22 +10,79 @@ typedef struct {
     uintptr_t esp;
     PageTable* page_table;
     File *stdout, *stdin, *stderr;
-    // add time
-    uint32_t time0;
-    uint32_t time1;
-    //
+    uint64_t wake_time; // monotonic nanoseconds
     uint8_t state;
     char name[64];
     uint32_t id;
+    uint32_t group_id;
+    uintptr_t thread_stack;
+    uint32_t exit_code;
+    uint8_t detached;
+    // cpu accounting, times are in tsc ticks
+    uint64_t user_time;
+    uint64_t kernel_time;
+    uint64_t account_start;
+    uint32_t context_switches;
+    uint32_t voluntary_switches;
+    uint32_t involuntary_switches;
+    uint8_t in_system_call;
+    uint8_t priority;
+    void* io_ring;
+    uint32_t io_ring_poller;
+    uint8_t io_ring_busy;
+    void* info_page;
+    uint32_t parent_id;
+    void* syscall_stats;
+    void* image;
 } Process;
 
+// bucket i counts the calls that took [2^i, 2^(i+1)) tsc ticks
+#define SYSCALL_STATS_BUCKETS 32
+// ioctl command of /sys/syscalls, arg points to a process id or SYSCALL_STATS_ALL to reset everything
+#define SYSCALL_STATS_ALL ((uint32_t)-1)
+#define SYSCALL_STATS_RESET 0
+
+// record read from /sys/syscalls, the kernel only has the file when built with SYSCALL_STATS=1
+typedef struct {
+    uint32_t process_id; // SYSCALL_STATS_ALL for the numbers of the whole system
+    uint32_t number;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t time; // total tsc ticks
+    uint32_t buckets[SYSCALL_STATS_BUCKETS];
+} SyscallStatsRecord;
+
+// record read from /sys/proc
+typedef struct {
+    uint32_t id;
+    uint32_t group_id;
+    uint8_t state;
+    char name[64];
+    uint32_t cpu;
+    uint64_t user_time;
+    uint64_t kernel_time;
+    uint32_t context_switches;
+    uint32_t voluntary_switches;
+    uint32_t involuntary_switches;
+} ProcessInfo;
+
 enum {
     PROCESS_TERMINATED = 0,
     PROCESS_RUNNING = 1,
     PROCESS_SUSPENDED = 2,
     PROCESS_SLEEPING = 3,
+    PROCESS_ZOMBIE = 4,
+};
+
+enum {
+    PROCESS_PRIORITY_LOW = 0,
+    PROCESS_PRIORITY_NORMAL = 1,
+    PROCESS_PRIORITY_HIGH = 2,
+    PROCESS_PRIORITY_HIGHEST = 3,
 };
 
+#define PROCESS_SELF ((uint32_t)-1)
+
 struct process_init_data {
     uint8_t initial_state;
     char* name;
@@ -39,7 +96,7 @@ struct process_init_data {
 static inline Process* get_current_process()
 {
     Process* process;
-    __asm__ volatile("int $0x40" : "=b"(process) : "a"(SYSCALL_GET_CURRENT_PROCESS));
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(process) : "a"(SYSCALL_GET_CURRENT_PROCESS));
     return process;
 }
 
@@ -59,10 +116,72 @@ static inline Process* create_process(char* name, uint8_t initial_state, uint32_
         .stderr = stderr_file,
     };
     Process* ret;
-    __asm__ volatile("int $0x40" : "=b"(ret) : "a"(SYSCALL_CREATE_PROCESS), "b"(&arg));
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(ret) : "a"(SYSCALL_CREATE_PROCESS), "b"(&arg));
+    return ret;
+}
+
+// starts a new thread in the current process at entry_point with ecx and edx set to the arguments
+// returns the id of the new thread or (uint32_t)-1 on fail
+static inline uint32_t create_thread(void* entry_point, uint32_t argument0, uint32_t argument1)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(ret) : "a"(SYSCALL_CREATE_THREAD), "b"(entry_point), "c"(argument0), "d"(argument1) : "memory");
     return ret;
 }
 
-Process* launch_file(char* path, File* stdout_file, File* stdin_file, File* stderr_file);
+static inline void exit_thread(uint32_t exit_code)
+{
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(SYSCALL_EXIT_THREAD), "b"(exit_code));
+}
+
+// blocks until the thread exits, returns 0 on success
+static inline uint32_t join_thread(uint32_t id, uint32_t* exit_code)
+{
+    uint32_t ret;
+    uint32_t code;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret), "=b"(code) : "a"(SYSCALL_JOIN_THREAD), "b"(id) : "memory");
+    if (ret == 0 && exit_code != 0) {
+        *exit_code = code;
+    }
+    return ret;
+}
+
+// changes the priority of a process or of the calling one if id is PROCESS_SELF, returns 0 on success
+static inline uint32_t set_priority(uint32_t id, uint8_t priority)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_SET_PRIORITY), "b"(id), "c"(priority));
+    return ret;
+}
+
+// changes the time slice given to every process of a priority, returns 0 on success
+static inline uint32_t set_quantum(uint8_t priority, uint32_t milliseconds)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_SET_QUANTUM), "b"(priority), "c"(milliseconds));
+    return ret;
+}
+
+struct spawn_data {
+    char* path;
+    char** argv;
+    File *stdout, *stdin, *stderr;
+};
+
+// the kernel loads the program at path and starts it with argv, which ends with NULL and can be NULL
+// returns the id of the new process or (uint32_t)-1 on fail
+static inline uint32_t spawn(char* path, char** argv, File* stdout_file, File* stdin_file, File* stderr_file)
+{
+    struct spawn_data arg = {
+        .path = path,
+        .argv = argv,
+        .stdout = stdout_file,
+        .stdin = stdin_file,
+        .stderr = stderr_file,
+    };
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=b"(ret) : "a"(SYSCALL_SPAWN), "b"(&arg) : "memory");
+    return ret;
+}
 
 #endif
@@ -1,6 +1,21 @@
 #ifndef ESTROS_SYSCALL_C
 #define ESTROS_SYSCALL_C
 
+// instructions entering the kernel, arguments and results use the same registers either way
+// the fast path pushes ecx, edx and the return address and passes the stack in ecx, the kernel restores both before the call runs
+// build with ESTROS_NO_SYSENTER for cpus without sysenter
+#define ESTROS_SYSCALL_INT "int $0x40\n\t"
+#ifdef ESTROS_NO_SYSENTER
+#define ESTROS_SYSCALL ESTROS_SYSCALL_INT
+#else
+#define ESTROS_SYSCALL "push %%ecx\n\t"      \
+                       "push %%edx\n\t"      \
+                       "push $1f\n\t"        \
+                       "mov %%esp, %%ecx\n\t" \
+                       "sysenter\n\t"        \
+                       "1:\n\t"
+#endif
+
 enum {
     // filesystem
     SYSCALL_OPEN = 0x02,
@@ -11,6 +26,12 @@ enum {
     SYSCALL_SEEK = 0x07,
     SYSCALL_TELL = 0x08,
     SYSCALL_CREATE_FILE = 0x09,
+    SYSCALL_READV = 0x0a,
+    SYSCALL_WRITEV = 0x0b,
+    SYSCALL_STAT = 0x0c,
+    SYSCALL_FSTAT = 0x0d,
+    SYSCALL_GET_DIRECTORY_ENTRIES = 0x0e,
+    SYSCALL_PIPE = 0x0f,
 
     // paging
     SYSCALL_REQUEST_NEW_PAGE = 0x10,
@@ -20,7 +41,27 @@ enum {
     // process
     SYSCALL_GET_CURRENT_PROCESS = 0x20,
     SYSCALL_CREATE_PROCESS = 0x21,
-    SYSCALL_EXIT = 0x22
+    SYSCALL_EXIT = 0x22,
+    SYSCALL_CREATE_THREAD = 0x23,
+    SYSCALL_EXIT_THREAD = 0x24,
+    SYSCALL_JOIN_THREAD = 0x25,
+    SYSCALL_SET_PRIORITY = 0x26,
+    SYSCALL_SPAWN = 0x27,
+    SYSCALL_SET_QUANTUM = 0x28,
+
+    // time
+    SYSCALL_CLOCK_GETTIME = 0x30,
+    SYSCALL_CLOCK_GETRES = 0x31,
+    SYSCALL_SLEEP = 0x32,
+
+    // io ring
+    SYSCALL_IO_RING_SETUP = 0x40,
+    SYSCALL_IO_RING_ENTER = 0x41,
+
+    // async io
+    SYSCALL_SUBMIT_IO = 0x42,
+    SYSCALL_WAIT_IO = 0x43,
+    SYSCALL_SEND_FILE = 0x44
 };
 
 #endif
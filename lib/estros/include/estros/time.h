@@ -0,0 +1,59 @@
+#ifndef ESTROS_TIME_H
+#define ESTROS_TIME_H
+
+#include <estros/syscall.h>
+#include <stdint.h>
+
+#define ESTROS_CLOCK_MONOTONIC 1
+
+// read only page the kernel maps into every process
+#define ESTROS_TIME_PAGE_ADDRESS 0x2FD000
+
+typedef struct {
+    uint32_t version;
+    uint32_t tsc_ticks_per_ms;
+    uint64_t tsc_boot; // tsc value at clock zero
+    uint32_t resolution_ns;
+} TimePage;
+
+typedef struct {
+    uint64_t seconds;
+    uint32_t nanoseconds;
+    uint32_t reserved;
+} ClockTime;
+
+static inline TimePage* get_time_page()
+{
+    return (TimePage*)ESTROS_TIME_PAGE_ADDRESS;
+}
+
+static inline uint64_t read_tsc()
+{
+    uint64_t tsc;
+    __asm__ volatile("rdtsc" : "=A"(tsc));
+    return tsc;
+}
+
+// returns 0 on success
+static inline uint32_t sys_clock_gettime(uint32_t clock_id, ClockTime* time)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_CLOCK_GETTIME), "b"(clock_id), "c"(time) : "memory");
+    return ret;
+}
+
+// returns 0 on success
+static inline uint32_t sys_clock_getres(uint32_t clock_id, ClockTime* time)
+{
+    uint32_t ret;
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(ret) : "a"(SYSCALL_CLOCK_GETRES), "b"(clock_id), "c"(time) : "memory");
+    return ret;
+}
+
+// blocks the calling thread for at least the given number of nanoseconds
+static inline void sys_sleep(uint64_t nanoseconds)
+{
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(SYSCALL_SLEEP), "b"((uint32_t)nanoseconds), "c"((uint32_t)(nanoseconds >> 32)) : "memory");
+}
+
+#endif
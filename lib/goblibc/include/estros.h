@@ -56,4 +56,13 @@ uint32_t sys_read(char *buffer, uint32_t len);
 /// @brief Clear the screen
 void sys_clear();
 
-void sys_set_cursor(uint16_t x, uint16_t y);
\ No newline at end of file
+void sys_set_cursor(uint16_t x, uint16_t y);
+
+/// @brief Id of the current process, read from the info page without a syscall
+uint32_t sys_get_pid();
+
+/// @brief Wait for a process started by this one to terminate, polls the info page between short sleeps
+/// @param id Id of the child process
+/// @param exit_code Where to store the exit code of the child, can be NULL
+/// @return 0 on success, -1 if the process isn't a recent child of this one
+int sys_wait_child(uint32_t id, uint32_t *exit_code);
\ No newline at end of file
@@ -0,0 +1,45 @@
+/**
+ * @file threads.h
+ * @brief Subset of the C11 threads.h implemented on top of EstrOS threads.
+ * Threads share the address space and std files of the process that created them.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t thrd_t;
+typedef int (*thrd_start_t)(void *);
+
+enum
+{
+    thrd_success = 0,
+    thrd_nomem = 1,
+    thrd_timedout = 2,
+    thrd_busy = 3,
+    thrd_error = 4,
+};
+
+/// @brief Start a new thread that runs func(arg)
+/// @param thr Where to store the id of the new thread
+/// @param func Function to run, its return value is the exit code of the thread
+/// @param arg Argument passed to func
+/// @return thrd_success or thrd_error
+int thrd_create(thrd_t *thr, thrd_start_t func, void *arg);
+
+/// @brief Get the id of the calling thread
+thrd_t thrd_current(void);
+
+int thrd_equal(thrd_t lhs, thrd_t rhs);
+
+/// @brief Terminate the calling thread
+/// @param res Exit code that will be returned to thrd_join
+void thrd_exit(int res);
+
+/// @brief Wait for a thread to finish
+/// @param thr Thread to wait for
+/// @param res Where to store the exit code, can be NULL
+/// @return thrd_success or thrd_error
+int thrd_join(thrd_t thr, int *res);
@@ -0,0 +1,31 @@
+/**
+ * @file time.h
+ * @brief Monotonic clock of EstrOS. Reads are done from the shared time page without a syscall.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+#pragma once
+
+#include <bits/alltypes.h>
+
+#define CLOCK_REALTIME 0
+#define CLOCK_MONOTONIC 1
+
+/// @brief Get the current value of a clock
+/// @param clock_id Only CLOCK_MONOTONIC is supported
+/// @param tp Where to store the time
+/// @return 0 on success, -1 and errno set to EINVAL for unsupported clocks
+int clock_gettime(clockid_t clock_id, struct timespec *tp);
+
+/// @brief Get the resolution of a clock
+/// @param clock_id Only CLOCK_MONOTONIC is supported
+/// @param res Where to store the resolution
+/// @return 0 on success, -1 and errno set to EINVAL for unsupported clocks
+int clock_getres(clockid_t clock_id, struct timespec *res);
+
+/// @brief Suspend the calling thread for at least the requested time
+/// @param req Time to sleep for
+/// @param rem Unused, sleeps are never interrupted so nothing remains
+/// @return 0 on success, -1 and errno set to EINVAL for an invalid request
+int nanosleep(const struct timespec *req, struct timespec *rem);
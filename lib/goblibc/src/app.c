@@ -1,32 +1,27 @@
 #include <estros.h>
 #include <stdlib.h>
 #include <estros/syscall.h>
-#include <estros/process.h>
+#include <estros/info.h>
 extern int main();
 
-int app_main()
+// part of .bss, the kernel only gives the app the pages it touches
+#define APP_HEAP_SIZE 0x100000
+static uint8_t app_heap[APP_HEAP_SIZE] __attribute__((aligned(4096)));
+
+// processes started with spawn get argc in ecx and argv in edx, both are 0 otherwise
+__attribute__((regparm(3))) int app_main(uint32_t unused, char **argv, int argc)
 {
+    (void)unused;
 
     // in the future this can be used to perform initialisation and such
     // init();
-    Process *p = get_current_process();
-    estros_stdin = p->stdin;
-    estros_stdout = p->stdout;
-    estros_stderr = p->stderr;
-    init_heap((uint8_t *)0x500000, 0x100000);
-    int res = main();
+    InfoPage *info = get_info_page();
+    estros_stdin = info->stdin;
+    estros_stdout = info->stdout;
+    estros_stderr = info->stderr;
+    init_heap(app_heap, APP_HEAP_SIZE);
+    int res = main(argc, argv);
     exit(res);
     // finish();
     // return 0;
 }
-
-int errno = 0;
-
-File *estros_stdin;
-File *estros_stdout;
-File *estros_stderr;
-
-int *__errno_location(void)
-{
-    return &errno;
-}
\ No newline at end of file
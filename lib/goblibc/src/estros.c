@@ -1,4 +1,12 @@
 #include <estros.h>
+#include <estros/info.h>
+#include <estros/process.h>
+#include <estros/time.h>
+
+// set by app_main from the info page
+File *estros_stdin;
+File *estros_stdout;
+File *estros_stderr;
 
 uint16_t *get_text_buffer_address()
 {
@@ -7,25 +15,47 @@ uint16_t *get_text_buffer_address()
 
 void sys_print(const char *str, uint32_t len)
 {
-    __asm__ volatile("int $0x40" ::"a"(5), "b"(estros_stdout), "c"(len), "d"(str) : "memory");
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(5), "b"(estros_stdout), "c"(len), "d"(str) : "memory");
 }
 
 uint32_t sys_read(char *buffer, uint32_t len)
 {
     uint32_t res = 0;
-    __asm__ volatile("int $0x40" : "=a"(res) : "a"(4), "b"(estros_stdin), "c"(len), "d"(buffer) : "memory");
+    __asm__ volatile(ESTROS_SYSCALL : "=a"(res) : "a"(4), "b"(estros_stdin), "c"(len), "d"(buffer) : "memory");
     return res;
 }
 
 void sys_clear()
 {
     uint32_t command = 0;
-    __asm__ volatile("int $0x40" ::"a"(6), "b"(estros_stdout), "c"(&command));
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(6), "b"(estros_stdout), "c"(&command));
 }
 
 void sys_set_cursor(uint16_t x, uint16_t y)
 {
     uint32_t command = 3;
     uint32_t arg = (x << 16) | y;
-    __asm__ volatile("int $0x40" ::"a"(6), "b"(estros_stdout), "c"(&command), "d"(arg));
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(6), "b"(estros_stdout), "c"(&command), "d"(arg));
+}
+
+uint32_t sys_get_pid()
+{
+    return get_process_id();
+}
+
+int sys_wait_child(uint32_t id, uint32_t *exit_code)
+{
+    uint32_t state;
+    while (1)
+    {
+        if (get_child_state(id, &state, exit_code) != 0)
+        {
+            return -1;
+        }
+        if (state == PROCESS_TERMINATED)
+        {
+            return 0;
+        }
+        sys_sleep(1000000);
+    }
 }
@@ -0,0 +1,3 @@
+// apps linked with this object get a PT_INTERP header, the kernel maps the shared goblibc named here before starting them
+// the app itself is linked against the library with --just-symbols, see lib/goblibc/makefile
+__attribute__((section(".interp"), used)) static const char interpreter[] = "/lib/goblibc.so";
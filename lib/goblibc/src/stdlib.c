@@ -408,5 +408,5 @@ long long stroll(const char *start, char **end, int base)
 
 void exit(int code)
 {
-    __asm__ volatile("int $0x40" ::"a"(SYSCALL_EXIT), "b"(code));
+    __asm__ volatile(ESTROS_SYSCALL ::"a"(SYSCALL_EXIT), "b"(code));
 }
\ No newline at end of file
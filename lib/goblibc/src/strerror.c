@@ -1,3 +1,10 @@
+int errno = 0;
+
+int *__errno_location(void)
+{
+    return &errno;
+}
+
 const char __uprefix[] = "Unknown error";
 
 // TODO: Update error list. Current values are copied from OpenBSD but don't fully match with ERRNO values
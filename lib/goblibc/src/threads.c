@@ -0,0 +1,53 @@
+#include <threads.h>
+#include <stdlib.h>
+#include <estros/process.h>
+
+// kernel starts the thread with the function in ecx and its argument in edx
+__attribute__((naked)) static void thread_entry()
+{
+    __asm__ volatile("push %edx\n\t"
+                     "call *%ecx\n\t"
+                     "push %eax\n\t"
+                     "call thrd_exit\n\t");
+}
+
+int thrd_create(thrd_t *thr, thrd_start_t func, void *arg)
+{
+    uint32_t id = create_thread((void *)thread_entry, (uint32_t)func, (uint32_t)arg);
+    if (id == (uint32_t)-1)
+    {
+        return thrd_error;
+    }
+    *thr = id;
+    return thrd_success;
+}
+
+thrd_t thrd_current(void)
+{
+    return get_current_process()->id;
+}
+
+int thrd_equal(thrd_t lhs, thrd_t rhs)
+{
+    return lhs == rhs;
+}
+
+void thrd_exit(int res)
+{
+    // the system call doesn't return
+    exit_thread(res);
+}
+
+int thrd_join(thrd_t thr, int *res)
+{
+    uint32_t code = 0;
+    if (join_thread(thr, &code) != 0)
+    {
+        return thrd_error;
+    }
+    if (res != NULL)
+    {
+        *res = (int)code;
+    }
+    return thrd_success;
+}
@@ -0,0 +1,47 @@
+#include <errno.h>
+#include <estros/time.h>
+#include <time.h>
+
+int clock_gettime(clockid_t clock_id, struct timespec *tp)
+{
+    if (clock_id != CLOCK_MONOTONIC || tp == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    TimePage *page = get_time_page();
+    uint64_t ticks = read_tsc() - page->tsc_boot;
+    uint64_t milliseconds = ticks / page->tsc_ticks_per_ms;
+    uint64_t nanoseconds = (ticks % page->tsc_ticks_per_ms) * 1000000 / page->tsc_ticks_per_ms;
+    tp->tv_sec = milliseconds / 1000;
+    tp->tv_nsec = (milliseconds % 1000) * 1000000 + nanoseconds;
+    return 0;
+}
+
+int clock_getres(clockid_t clock_id, struct timespec *res)
+{
+    if (clock_id != CLOCK_MONOTONIC || res == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    res->tv_sec = 0;
+    res->tv_nsec = get_time_page()->resolution_ns;
+    return 0;
+}
+
+int nanosleep(const struct timespec *req, struct timespec *rem)
+{
+    if (req == 0 || req->tv_sec < 0 || req->tv_nsec < 0 || req->tv_nsec >= 1000000000)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    sys_sleep((uint64_t)req->tv_sec * 1000000000 + req->tv_nsec);
+    if (rem != 0)
+    {
+        rem->tv_sec = 0;
+        rem->tv_nsec = 0;
+    }
+    return 0;
+}
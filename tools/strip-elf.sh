@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Check for input directory
+if [[ -z "$1" ]]; then
+    echo "Usage: $0 <directory>"
+    exit 1
+fi
+
+INPUT_DIR="$1"
+
+# The kernel loads the elf segments directly, only the symbols and debug info are removed
+# the unstripped files stay in build/apps for gdb
+find "$INPUT_DIR" -type f | while read -r file; do
+    # Check if it's an ELF file
+    if file "$file" | grep -q "ELF"; then
+        echo "Processing: $file"
+
+        if ! objcopy --strip-all "$file"; then
+            echo "  Skipping (objcopy failed)"
+            continue
+        fi
+
+        echo "  Stripped"
+    fi
+done